@@ -1,24 +1,157 @@
 #include "AudioAnalyzer.h"
+#include "FastMath.h"
+#include "FrameKernels.h"
+#include "KeyProfiles.h"
+#include "MusicTheory.h"
 #include <cmath>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
-// ── Albrecht & Shanahan (2013) key profiles ──────────────────────────────
-// Derived from large corpus analysis of real music. Best empirical accuracy
-// in benchmarks; significantly better than Krumhansl (1990) and Temperley (1999).
-// Profile index 0 = tonic, rotated for each root note.
-static const double KEY_PROFILE_MAJOR[12] = {
-    0.238, 0.006, 0.111, 0.006, 0.137, 0.094, 0.016, 0.214, 0.009, 0.080, 0.008, 0.081
+static const char* const NOTE_NAMES[12] = { "C","C#","D","D#","E","F","F#","G","G#","A","A#","B" };
+
+// Chord templates: quality, display suffix, chord tones relative to the root
+struct ChordTemplate { const char* quality; const char* suffix; int tones[4]; int numTones; };
+static const ChordTemplate CHORD_TEMPLATES[] = {
+    { "maj",  "",         { 0, 4, 7 },     3 },
+    { "min",  "m",        { 0, 3, 7 },     3 },
+    { "dim",  "\xc2\xb0", { 0, 3, 6 },     3 },   // °
+    { "sus2", "sus2",     { 0, 2, 7 },     3 },
+    { "sus4", "sus4",     { 0, 5, 7 },     3 },
+    { "7",    "7",        { 0, 4, 7, 10 }, 4 },
+    { "maj7", "maj7",     { 0, 4, 7, 11 }, 4 },
+    { "min7", "m7",       { 0, 3, 7, 10 }, 4 }
 };
-static const double KEY_PROFILE_MINOR[12] = {
-    0.220, 0.006, 0.104, 0.123, 0.019, 0.103, 0.012, 0.214, 0.062, 0.022, 0.061, 0.052
+static constexpr int NUM_CHORD_QUALITIES = (int) (sizeof (CHORD_TEMPLATES) / sizeof (CHORD_TEMPLATES[0]));
+
+// ── Streaming median ─────────────────────────────────────────────────────
+// Median of the last `size` values pushed (zeros before the first push).
+// The window is kept sorted: each update is a binary search plus a short
+// move of at most `size` floats.
+class SlidingMedian
+{
+public:
+    void reset (int size)
+    {
+        sorted.assign ((size_t) size, 0.0f);
+        history.assign ((size_t) size, 0.0f);
+        next = 0;
+    }
+
+    void push (float value)
+    {
+        float old = history[(size_t) next];
+        history[(size_t) next] = value;
+        next = (next + 1) % (int) history.size();
+
+        auto oldPos = std::lower_bound (sorted.begin(), sorted.end(), old);
+        auto newPos = std::lower_bound (sorted.begin(), sorted.end(), value);
+        if (newPos > oldPos)
+        {
+            std::rotate (oldPos, oldPos + 1, newPos);
+            --newPos;
+        }
+        else
+            std::rotate (newPos, oldPos, oldPos + 1);
+        *newPos = value;
+    }
+
+    float median() const { return sorted[sorted.size() / 2]; }
+
+private:
+    std::vector<float> sorted, history;
+    int next = 0;
 };
 
-// Scale intervals for building pitch class sets from detected key
-static const int MAJOR_INTERVALS[7] = { 0, 2, 4, 5, 7, 9, 11 };
-static const int MINOR_INTERVALS[7] = { 0, 2, 3, 5, 7, 8, 10 };
+// ── Harmonic/percussive separation (Fitzgerald 2010) ─────────────────────
+// Streaming median-filter HPSS: harmonic energy is smooth across time,
+// percussive energy is smooth across frequency. Each pushed frame updates a
+// per-bin time median; the frame from latency() pushes ago is then masked
+// with H² / (H² + P²). Memory is timeFrames spectra of numBins bins.
+class HarmonicSeparator
+{
+public:
+    void prepare (int bins, int timeFrameCount, int freqBinCount, bool keepPhase)
+    {
+        numBins = bins;
+        timeFrames = timeFrameCount;
+        freqBins = freqBinCount;
+        withPhase = keepPhase;
+
+        timeMedians.resize ((size_t) numBins);
+        for (auto& m : timeMedians) m.reset (timeFrames);
+        freqMedian.reset (freqBins);
+
+        ringMag.assign ((size_t) (timeFrames * numBins), 0.0f);
+        ringRe.assign (withPhase ? ringMag.size() : 0, 0.0f);
+        ringIm.assign (withPhase ? ringMag.size() : 0, 0.0f);
+        percussive.assign ((size_t) numBins, 0.0f);
+        newest = timeFrames - 1;
+    }
+
+    int latency() const { return timeFrames / 2; }
+
+    // Adds the next frame; nullptr magnitudes = silent frame
+    void push (const float* mag, const float* re, const float* im)
+    {
+        newest = (newest + 1) % timeFrames;
+        float* slotMag = ringMag.data() + (size_t) (newest * numBins);
+        for (int b = 0; b < numBins; ++b)
+        {
+            slotMag[b] = mag != nullptr ? mag[b] : 0.0f;
+            timeMedians[(size_t) b].push (slotMag[b]);
+        }
+        if (withPhase)
+        {
+            float* slotRe = ringRe.data() + (size_t) (newest * numBins);
+            float* slotIm = ringIm.data() + (size_t) (newest * numBins);
+            for (int b = 0; b < numBins; ++b)
+            {
+                slotRe[b] = mag != nullptr ? re[b] : 0.0f;
+                slotIm[b] = mag != nullptr ? im[b] : 0.0f;
+            }
+        }
+    }
+
+    // Writes the harmonic part of the centre frame (latency() pushes ago)
+    void getHarmonic (float* mag, float* re, float* im)
+    {
+        int centre = (newest - latency() + timeFrames) % timeFrames;
+        const float* centreMag = ringMag.data() + (size_t) (centre * numBins);
+
+        // Median across frequency of the centre frame (zero-padded at the edges)
+        int half = freqBins / 2;
+        freqMedian.reset (freqBins);
+        for (int b = 0; b < numBins + half; ++b)
+        {
+            freqMedian.push (b < numBins ? centreMag[b] : 0.0f);
+            if (b >= half)
+                percussive[(size_t) (b - half)] = freqMedian.median();
+        }
+
+        for (int b = 0; b < numBins; ++b)
+        {
+            float h = timeMedians[(size_t) b].median();
+            float p = percussive[(size_t) b];
+            float mask = (h * h) / (h * h + p * p + 1.0e-12f);
+            mag[b] = centreMag[b] * mask;
+            if (withPhase)
+            {
+                re[b] = ringRe[(size_t) (centre * numBins + b)] * mask;
+                im[b] = ringIm[(size_t) (centre * numBins + b)] * mask;
+            }
+        }
+    }
+
+private:
+    int numBins = 0, timeFrames = 1, freqBins = 1;
+    bool withPhase = false;
+    std::vector<SlidingMedian> timeMedians;
+    SlidingMedian freqMedian;
+    std::vector<float> ringMag, ringRe, ringIm, percussive;
+    int newest = 0;
+};
 
 AudioAnalyzer::AudioAnalyzer() : Thread ("AudioAnalyzer") {}
 
@@ -27,13 +160,15 @@ AudioAnalyzer::~AudioAnalyzer()
     stopThread (5000);
 }
 
-void AudioAnalyzer::analyzeFile (const juce::File& audioFile, double hostSampleRate)
+void AudioAnalyzer::analyzeFile (const juce::File& audioFile, double hostSampleRate, bool shouldDetectTempo)
 {
     // Stop any running analysis
     stopThread (3000);
 
     fileToAnalyze = audioFile;
-    targetSampleRate = hostSampleRate > 0 ? hostSampleRate : 44100.0;
+    detectTempo = shouldDetectTempo;
+    targetSampleRate = analysisSampleRate > 0.0 ? analysisSampleRate
+                     : hostSampleRate > 0 ? hostSampleRate : 44100.0;
     analysisComplete.store (false);
 
     {
@@ -42,6 +177,15 @@ void AudioAnalyzer::analyzeFile (const juce::File& audioFile, double hostSampleR
         alternativeKeys.clear();
         detectedBPM = 0.0f;
         detectedBPMConfidence = 0.0f;
+        detectedTuningHz = 440.0f;
+        chromagram = {};
+        keySegments.clear();
+        chordTimeline.clear();
+        descriptors = {};
+        keyChroma = {};
+        detectedScale = {};
+        beatGrid = {};
+        tempogram.clear();
         songTitle.clear();
         songArtist.clear();
         coverArt = {};
@@ -50,6 +194,45 @@ void AudioAnalyzer::analyzeFile (const juce::File& audioFile, double hostSampleR
     startThread();
 }
 
+void AudioAnalyzer::applyPreset (QualityPreset preset)
+{
+    // Settings every preset shares, so switching presets never leaves a
+    // field from the previous one behind
+    keyProfileSet = KeyProfileSet::ensemble;   estimateTuning = true;   detectModes = true;
+    bpmBands = 3;     bpmBandEdgesHz = { 50.0f, 300.0f, 2000.0f };      tempogramMode = false;
+    cqtBinsPerSemitone = 3;
+
+    switch (preset)
+    {
+        case QualityPreset::instant:
+            fftSize = 4096;   hopFraction = 0.5f;   analysisSampleRate = 22050.0;  maxAnalysisSeconds = 90.0f;
+            minBPM = 60.0f;   maxBPM = 200.0f;      bpmStep = 0.5f;
+            bpmEarlyExitSharpness = 0.4f;           bpmDecimation = 2;
+            chromaFrontEnd = ChromaFrontEnd::semitoneFilterbank;
+            separateHarmonics = false;  trackKeyChanges = false;  detectChords = false;
+            computeTempogram = false;   trackBeats = false;       detectMeter = false;
+            break;
+
+        case QualityPreset::balanced:
+            fftSize = 8192;   hopFraction = 0.5f;   analysisSampleRate = 0.0;      maxAnalysisSeconds = 0.0f;
+            minBPM = 50.0f;   maxBPM = 220.0f;      bpmStep = 0.25f;
+            bpmEarlyExitSharpness = 1.1f;           bpmDecimation = 1;
+            chromaFrontEnd = ChromaFrontEnd::semitoneFilterbank;
+            separateHarmonics = false;  trackKeyChanges = true;   detectChords = true;
+            computeTempogram = true;    trackBeats = true;        detectMeter = true;
+            break;
+
+        case QualityPreset::precise:
+            fftSize = 16384;  hopFraction = 0.25f;  analysisSampleRate = 0.0;      maxAnalysisSeconds = 0.0f;
+            minBPM = 50.0f;   maxBPM = 220.0f;      bpmStep = 0.1f;
+            bpmEarlyExitSharpness = 1.1f;           bpmDecimation = 1;
+            chromaFrontEnd = ChromaFrontEnd::constantQ;
+            separateHarmonics = true;   trackKeyChanges = true;   detectChords = true;
+            computeTempogram = true;    trackBeats = true;        detectMeter = true;
+            break;
+    }
+}
+
 bool AudioAnalyzer::isAnalysisComplete()
 {
     return analysisComplete.exchange (false);
@@ -85,6 +268,67 @@ float AudioAnalyzer::getDetectedBPMConfidence() const
     return detectedBPMConfidence;
 }
 
+float AudioAnalyzer::getDetectedTuningHz() const
+{
+    const juce::ScopedLock sl (resultLock);
+    return detectedTuningHz;
+}
+
+AudioAnalyzer::Chromagram AudioAnalyzer::getChromagram() const
+{
+    const juce::ScopedLock sl (resultLock);
+    return chromagram;
+}
+
+std::vector<AudioAnalyzer::KeySegment> AudioAnalyzer::getKeySegments() const
+{
+    const juce::ScopedLock sl (resultLock);
+    return keySegments;
+}
+
+std::vector<AudioAnalyzer::ChordEvent> AudioAnalyzer::getChordTimeline() const
+{
+    const juce::ScopedLock sl (resultLock);
+    return chordTimeline;
+}
+
+AudioAnalyzer::DetectedScale AudioAnalyzer::getDetectedScale() const
+{
+    const juce::ScopedLock sl (resultLock);
+    return detectedScale;
+}
+
+std::vector<AudioAnalyzer::TempoPoint> AudioAnalyzer::getTempogram() const
+{
+    const juce::ScopedLock sl (resultLock);
+    return tempogram;
+}
+
+AudioAnalyzer::BeatGrid AudioAnalyzer::getBeatGrid() const
+{
+    const juce::ScopedLock sl (resultLock);
+    return beatGrid;
+}
+
+std::array<double, 24> AudioAnalyzer::getKeyCorrelations (KeyProfileSet set) const
+{
+    std::array<double, 12> x;
+    {
+        const juce::ScopedLock sl (resultLock);
+        x = keyChroma;
+    }
+
+    std::array<double, 24> r {};
+    correlateKeys (set, x.data(), 1, r.data());
+    return r;
+}
+
+AudioAnalyzer::Descriptors AudioAnalyzer::getDescriptors() const
+{
+    const juce::ScopedLock sl (resultLock);
+    return descriptors;
+}
+
 juce::String AudioAnalyzer::getSongTitle() const
 {
     const juce::ScopedLock sl (resultLock);
@@ -103,6 +347,103 @@ juce::Image AudioAnalyzer::getCoverArt() const
     return coverArt;
 }
 
+// ── Autocorrelation ──────────────────────────────────────────────────────
+// Linear (non-circular) autocorrelation r[k] = Σ x[i]·x[i+k] for lags
+// 0..maxLag, via a zero-padded FFT: O(n log n) instead of O(n · maxLag).
+void AudioAnalyzer::Autocorrelator::prepare (int maxLength, int lagsToKeep)
+{
+    maxLag = juce::jmax (0, lagsToKeep);
+    // Padding to length + maxLag keeps the circular wrap-around out of lags 0..maxLag
+    int newSize = juce::nextPowerOfTwo (juce::jmax (1, maxLength) + maxLag + 1);
+    if (newSize != size)
+    {
+        size = newSize;
+        fft.init ((size_t) size);
+        size_t bins = audiofft::AudioFFT::ComplexSize ((size_t) size);
+        padded.resize ((size_t) size);
+        re.resize (bins);
+        im.resize (bins);
+    }
+}
+
+const std::vector<float>& AudioAnalyzer::Autocorrelator::process (const float* x, int n)
+{
+    result.assign ((size_t) juce::jlimit (0, juce::jmax (0, n - 1), maxLag) + 1, 0.0f);
+    if (n <= 0)
+        return result;
+
+    std::fill (std::copy (x, x + n, padded.begin()), padded.end(), 0.0f);
+    fft.fft (padded.data(), re.data(), im.data());
+    for (size_t b = 0; b < re.size(); ++b)
+    {
+        re[b] = re[b] * re[b] + im[b] * im[b];
+        im[b] = 0.0f;
+    }
+    fft.ifft (padded.data(), re.data(), im.data());
+
+    std::copy (padded.begin(), padded.begin() + (std::ptrdiff_t) result.size(), result.begin());
+    return result;
+}
+
+// Tempo score of an onset envelope from its integer-lag autocorrelation.
+// Fractional lags interpolate the envelope → no quantisation error; the
+// interpolated dot product over count = n - lagI - 1 terms is
+//   (1 - frac)·(AC[lagI] - env[n-1-lagI]·env[n-1]) + frac·AC[lagI+1]
+// (the first sum lacks AC[lagI]'s last term), so each lookup is O(1).
+struct TempoScorer
+{
+    const float* env = nullptr;
+    int n = 0;
+    const std::vector<float>* ac = nullptr;
+    double framesPerMinute = 0.0;
+    float lagMaxF = 0.0f;                // Longest lag searched (slowest tempo)
+    float minBPM = 0.0f, maxBPM = 0.0f;
+
+    float acFrac (float lagF) const
+    {
+        if (lagF < 1.0f || lagF >= (float) (n - 1)) return 0.0f;
+        int   lagI  = (int) lagF;
+        float frac  = lagF - (float) lagI;
+        int   count = n - lagI - 1;
+        if (count <= 0 || lagI + 1 >= (int) ac->size()) return 0.0f;
+        float head = (*ac)[(size_t) lagI] - env[n - 1 - lagI] * env[n - 1];
+        float sum  = (1.0f - frac) * head + frac * (*ac)[(size_t) (lagI + 1)];
+        return sum / (float) count;
+    }
+
+    // 4-harmonic weighting: AC(T) + 0.5*AC(2T) + 0.25*AC(3T) + 0.125*AC(4T)
+    float score (float bpm) const
+    {
+        if (bpm < minBPM || bpm > maxBPM) return 0.0f;
+        float lagF = (float) (framesPerMinute / (double) bpm);
+        float s = acFrac (lagF);
+        if (lagF * 2.0f <= lagMaxF) s += 0.5f   * acFrac (lagF * 2.0f);
+        if (lagF * 3.0f <= lagMaxF) s += 0.25f  * acFrac (lagF * 3.0f);
+        if (lagF * 4.0f <= lagMaxF) s += 0.125f * acFrac (lagF * 4.0f);
+        return s;
+    }
+
+    // Octave correction: check ×2 and ×0.5 candidates; prefer whichever falls
+    // in the 70-155 BPM "natural" range without sacrificing accuracy
+    float naturalOctave (float bestBPM, float bestScore) const
+    {
+        float candidateBPMs[3] = { bestBPM, bestBPM * 2.0f, bestBPM * 0.5f };
+        float naturalBPM   = 0.0f;
+        float naturalScore = 0.0f;
+
+        for (float cb : candidateBPMs)
+        {
+            if (cb >= 70.0f && cb <= 155.0f)
+            {
+                float cs = score (cb);
+                if (cs > naturalScore) { naturalScore = cs; naturalBPM = cb; }
+            }
+        }
+
+        return (naturalBPM > 0.0f && naturalScore >= 0.45f * bestScore) ? naturalBPM : bestBPM;
+    }
+};
+
 // ── ID3v2 tag parser ─────────────────────────────────────────────────────
 AudioAnalyzer::SongMetadata AudioAnalyzer::parseID3v2Tags (const juce::File& file)
 {
@@ -201,37 +542,666 @@ AudioAnalyzer::SongMetadata AudioAnalyzer::parseID3v2Tags (const juce::File& fil
     return meta;
 }
 
-int AudioAnalyzer::hzToMidi (float hz)
+double AudioAnalyzer::hzToFractionalMidi (double hz, double referenceHz)
+{
+    return 69.0 + 12.0 * std::log2 (hz / referenceHz);
+}
+
+double AudioAnalyzer::midiToHz (double midi, double referenceHz)
+{
+    return referenceHz * std::pow (2.0, (midi - 69.0) / 12.0);
+}
+
+int AudioAnalyzer::hzToMidi (float hz, double referenceHz)
 {
     if (hz <= 0.0f) return -1;
-    return (int) std::round (69.0 + 12.0 * std::log2 ((double) hz / 440.0));
+    return (int) std::round (hzToFractionalMidi ((double) hz, referenceHz));
 }
 
-int AudioAnalyzer::hzToPitchClass (float hz)
+int AudioAnalyzer::hzToPitchClass (float hz, double referenceHz)
 {
-    int midi = hzToMidi (hz);
+    int midi = hzToMidi (hz, referenceHz);
     if (midi < 0) return -1;
     return midi % 12;
 }
 
-double AudioAnalyzer::pearsonCorrelation (const double* x, const double* y, int n)
+void AudioAnalyzer::correlateKeys (KeyProfileSet set, const double* chroma, int numFrames, double* r)
 {
-    double sumX = 0, sumY = 0;
-    for (int i = 0; i < n; ++i) { sumX += x[i]; sumY += y[i]; }
-    double meanX = sumX / n;
-    double meanY = sumY / n;
+    switch (set)
+    {
+        case KeyProfileSet::albrechtShanahan: keyprofiles::correlate (keyprofiles::ALBRECHT_SHANAHAN, chroma, numFrames, r); break;
+        case KeyProfileSet::krumhanslKessler: keyprofiles::correlate (keyprofiles::KRUMHANSL_KESSLER, chroma, numFrames, r); break;
+        case KeyProfileSet::temperley:        keyprofiles::correlate (keyprofiles::TEMPERLEY, chroma, numFrames, r);         break;
+        case KeyProfileSet::edm:              keyprofiles::correlate (keyprofiles::EDM, chroma, numFrames, r);               break;
+        case KeyProfileSet::ensemble:         keyprofiles::correlateEnsemble (chroma, numFrames, r);                         break;
+    }
+}
+
+void AudioAnalyzer::buildConstantQKernel (ConstantQKernel& kernel, int fftSize, double sampleRate,
+                                          float minHz, float maxHz, int binsPerSemitone,
+                                          double referenceHz)
+{
+    if (kernel.fftSize == fftSize && kernel.sampleRate == sampleRate
+        && kernel.minHz == minHz && kernel.maxHz == maxHz
+        && kernel.binsPerSemitone == binsPerSemitone && kernel.referenceHz == referenceHz)
+        return;
+
+    kernel = {};
+    kernel.fftSize = fftSize;
+    kernel.sampleRate = sampleRate;
+    kernel.minHz = minHz;
+    kernel.maxHz = maxHz;
+    kernel.binsPerSemitone = binsPerSemitone;
+    kernel.referenceHz = referenceHz;
+    kernel.rowStart.push_back (0);
 
-    double num = 0, denX = 0, denY = 0;
-    for (int i = 0; i < n; ++i)
+    // Q for the requested resolution; the lowest bins are capped at the frame
+    // length, so the transform degrades to variable-Q in the bass octaves
+    const double q = 1.0 / (std::pow (2.0, 1.0 / (12.0 * binsPerSemitone)) - 1.0);
+    const double sparsity = 0.0054;   // Drop kernel entries below this fraction of the row peak
+
+    audiofft::AudioFFT fft;
+    fft.init ((size_t) fftSize);
+    size_t complexSize = audiofft::AudioFFT::ComplexSize ((size_t) fftSize);
+    std::vector<float> cosKernel ((size_t) fftSize), sinKernel ((size_t) fftSize);
+    std::vector<float> cosRe (complexSize), cosIm (complexSize), sinRe (complexSize), sinIm (complexSize);
+
+    // Bins centred on each semitone (plus ±1/3 semitone neighbours at 3 bins/semitone)
+    int half = binsPerSemitone / 2;
+    int firstMidi = (int) std::floor (hzToFractionalMidi ((double) minHz, referenceHz));
+    int lastMidi  = (int) std::ceil  (hzToFractionalMidi ((double) maxHz, referenceHz));
+
+    for (int midi = firstMidi; midi <= lastMidi; ++midi)
     {
-        double dx = x[i] - meanX;
-        double dy = y[i] - meanY;
-        num += dx * dy;
-        denX += dx * dx;
-        denY += dy * dy;
+        for (int sub = -half; sub <= half; ++sub)
+        {
+            double freq = midiToHz ((double) midi + (double) sub / binsPerSemitone, referenceHz);
+            if (freq < minHz || freq > maxHz || freq >= sampleRate * 0.5) continue;
+
+            // Windowed complex exponential, centred in the frame and normalised by its length
+            int length = juce::jmin (fftSize, (int) std::ceil (q * sampleRate / freq));
+            int start  = (fftSize - length) / 2;
+            std::fill (cosKernel.begin(), cosKernel.end(), 0.0f);
+            std::fill (sinKernel.begin(), sinKernel.end(), 0.0f);
+            for (int n = 0; n < length; ++n)
+            {
+                double w     = 0.5 * (1.0 - std::cos (2.0 * M_PI * n / (double) (length - 1))) / length;
+                double phase = 2.0 * M_PI * freq * n / sampleRate;
+                cosKernel[(size_t) (start + n)] = (float) (w * std::cos (phase));
+                sinKernel[(size_t) (start + n)] = (float) (w * std::sin (phase));
+            }
+
+            // Complex spectrum from two real FFTs: K = FFT(cos) + i·FFT(sin)
+            fft.fft (cosKernel.data(), cosRe.data(), cosIm.data());
+            fft.fft (sinKernel.data(), sinRe.data(), sinIm.data());
+
+            float peak = 0.0f;
+            for (size_t j = 0; j < complexSize; ++j)
+            {
+                float kr = cosRe[j] - sinIm[j];
+                float ki = cosIm[j] + sinRe[j];
+                cosRe[j] = kr;
+                cosIm[j] = ki;
+                peak = juce::jmax (peak, std::sqrt (kr * kr + ki * ki));
+            }
+
+            // Keep the significant entries, stored conjugated for the frame product
+            for (size_t j = 0; j < complexSize; ++j)
+            {
+                float kr = cosRe[j], ki = cosIm[j];
+                if (std::sqrt (kr * kr + ki * ki) < peak * (float) sparsity) continue;
+                kernel.fftBin.push_back ((int) j);
+                kernel.re.push_back (kr);
+                kernel.im.push_back (-ki);
+            }
+            kernel.rowStart.push_back ((int) kernel.fftBin.size());
+            kernel.pitchClass.push_back (((midi % 12) + 12) % 12);
+        }
     }
-    if (denX <= 0.0 || denY <= 0.0) return 0.0;
-    return num / (std::sqrt (denX) * std::sqrt (denY));
+
+    DBG ("AudioAnalyzer: Constant-Q kernel has " + juce::String (kernel.numBins()) + " bins, "
+         + juce::String ((int) kernel.fftBin.size()) + " non-zero entries");
+}
+
+// ── Local key tracking ───────────────────────────────────────────────────
+// Sums the per-frame chroma over sliding windows, correlates every window
+// with all 24 key profiles in one matrix product, then finds the best key
+// path with Viterbi (staying in key is free, modulating costs a penalty).
+std::vector<AudioAnalyzer::KeySegment> AudioAnalyzer::trackKeySegments (const double* frameChromas,
+                                                                        const uint8_t* frameVoiced,
+                                                                        int numFrames, double hopSeconds,
+                                                                        double durationSeconds) const
+{
+    std::vector<KeySegment> segments;
+    if (numFrames <= 0 || hopSeconds <= 0.0 || durationSeconds <= 0.0)
+        return segments;
+
+    // Prefix sums of voiced chroma → any window sum in O(12)
+    std::vector<double> prefix ((size_t) (numFrames + 1) * 12, 0.0);
+    for (int f = 0; f < numFrames; ++f)
+        for (int i = 0; i < 12; ++i)
+            prefix[(size_t) (f + 1) * 12 + (size_t) i] = prefix[(size_t) f * 12 + (size_t) i]
+                + (frameVoiced[f] ? frameChromas[(size_t) f * 12 + (size_t) i] : 0.0);
+
+    double windowHop = juce::jmax (0.1, (double) keyWindowHopSeconds);
+    double halfWindow = juce::jmax ((double) keyWindowSeconds, windowHop) * 0.5;
+    int numWindows = juce::jmax (1, (int) std::ceil (durationSeconds / windowHop));
+
+    // Window chroma sums, then correlations: (24 × 12) · (12 × numWindows)
+    std::vector<double> windowChroma ((size_t) numWindows * 12, 0.0);
+    for (int w = 0; w < numWindows; ++w)
+    {
+        double centre = (w + 0.5) * windowHop;
+        int lo = juce::jlimit (0, numFrames, (int) std::ceil  ((centre - halfWindow) / hopSeconds));
+        int hi = juce::jlimit (0, numFrames, (int) std::floor ((centre + halfWindow) / hopSeconds));
+
+        double* x = windowChroma.data() + (size_t) w * 12;
+        for (int i = 0; i < 12; ++i)
+            x[i] = prefix[(size_t) hi * 12 + (size_t) i] - prefix[(size_t) lo * 12 + (size_t) i];
+    }
+
+    std::vector<double> corr ((size_t) numWindows * keyprofiles::numKeys, 0.0);
+    correlateKeys (keyProfileSet, windowChroma.data(), numWindows, corr.data());
+
+    // Transition costs: related keys share most of their pitch classes
+    double transition[24][24];
+    for (int from = 0; from < 24; ++from)
+    {
+        for (int to = 0; to < 24; ++to)
+        {
+            int fromRoot = from % 12, toRoot = to % 12;
+            bool sameMode = (from < 12) == (to < 12);
+            int interval = (toRoot - fromRoot + 12) % 12;
+
+            bool related = (sameMode && (interval == 5 || interval == 7))       // fifth neighbours
+                        || (! sameMode && interval == 0)                        // parallel
+                        || (from < 12 && to >= 12 && interval == 9)             // relative minor
+                        || (from >= 12 && to < 12 && interval == 3);            // relative major
+
+            transition[from][to] = from == to ? 0.0
+                                 : related ? (double) relatedKeyChangePenalty
+                                           : (double) keyChangePenalty;
+        }
+    }
+
+    // Viterbi decode
+    std::vector<double> score (corr.begin(), corr.begin() + 24);
+    std::vector<uint8_t> backPointer ((size_t) numWindows * 24, 0);
+    std::vector<double> nextScore (24);
+    for (int w = 1; w < numWindows; ++w)
+    {
+        for (int to = 0; to < 24; ++to)
+        {
+            double best = -1.0e30;
+            int bestFrom = to;
+            for (int from = 0; from < 24; ++from)
+            {
+                double s = score[(size_t) from] - transition[from][to];
+                if (s > best) { best = s; bestFrom = from; }
+            }
+            nextScore[(size_t) to] = best + corr[(size_t) w * 24 + (size_t) to];
+            backPointer[(size_t) w * 24 + (size_t) to] = (uint8_t) bestFrom;
+        }
+        std::swap (score, nextScore);
+    }
+
+    std::vector<int> path ((size_t) numWindows);
+    path.back() = (int) (std::max_element (score.begin(), score.end()) - score.begin());
+    for (int w = numWindows - 1; w > 0; --w)
+        path[(size_t) w - 1] = backPointer[(size_t) w * 24 + (size_t) path[(size_t) w]];
+
+    // Collapse the path into segments
+    for (int w = 0; w < numWindows; )
+    {
+        int key = path[(size_t) w];
+        int end = w;
+        double corrSum = 0.0;
+        while (end < numWindows && path[(size_t) end] == key)
+            corrSum += corr[(size_t) end++ * 24 + (size_t) key];
+
+        KeySegment seg;
+        seg.startSeconds = w * windowHop;
+        seg.endSeconds   = juce::jmin (durationSeconds, end * windowHop);
+        seg.root         = key % 12;
+        seg.isMajor      = key < 12;
+        seg.name         = juce::String (NOTE_NAMES[seg.root]) + (seg.isMajor ? " Major" : " Minor");
+        seg.correlation  = (float) (corrSum / (end - w));
+        segments.push_back (seg);
+        w = end;
+    }
+
+    return segments;
+}
+
+// ── Chord tracking ───────────────────────────────────────────────────────
+// Scores every voiced frame against all chord templates (unit-norm binary
+// masks, so each score is a cosine similarity) block by block as one
+// (frames × 12) · (12 × chords) product, then smooths the sequence with
+// Viterbi under a uniform chord-change penalty.
+std::vector<AudioAnalyzer::ChordEvent> AudioAnalyzer::trackChords (const double* frameChromas,
+                                                                   const uint8_t* frameVoiced,
+                                                                   int numFrames, double hopSeconds) const
+{
+    std::vector<ChordEvent> events;
+
+    std::vector<int> voicedFrames;
+    for (int f = 0; f < numFrames; ++f)
+        if (frameVoiced[f]) voicedFrames.push_back (f);
+    if (voicedFrames.empty())
+        return events;
+
+    // Template matrix: row = root * NUM_CHORD_QUALITIES + quality
+    const int numChords = 12 * NUM_CHORD_QUALITIES;
+    std::vector<double> templates ((size_t) numChords * 12, 0.0);
+    for (int root = 0; root < 12; ++root)
+    {
+        for (int q = 0; q < NUM_CHORD_QUALITIES; ++q)
+        {
+            const auto& t = CHORD_TEMPLATES[q];
+            double weight = 1.0 / std::sqrt ((double) t.numTones);
+            for (int i = 0; i < t.numTones; ++i)
+                templates[(size_t) (root * NUM_CHORD_QUALITIES + q) * 12 + (size_t) ((root + t.tones[i]) % 12)] = weight;
+        }
+    }
+
+    // Scores, one block of frames at a time (keeps the block in cache)
+    const int numObs = (int) voicedFrames.size();
+    const int blockSize = 256;
+    std::vector<double> scores ((size_t) numObs * (size_t) numChords);
+    std::vector<double> block ((size_t) blockSize * 12);
+    for (int b0 = 0; b0 < numObs; b0 += blockSize)
+    {
+        int rows = juce::jmin (blockSize, numObs - b0);
+        for (int r = 0; r < rows; ++r)
+            std::copy (frameChromas + (size_t) voicedFrames[(size_t) (b0 + r)] * 12,
+                       frameChromas + (size_t) voicedFrames[(size_t) (b0 + r)] * 12 + 12,
+                       block.begin() + r * 12);
+
+        for (int r = 0; r < rows; ++r)
+        {
+            const double* x = block.data() + (size_t) r * 12;
+            double* out = scores.data() + (size_t) (b0 + r) * (size_t) numChords;
+            for (int c = 0; c < numChords; ++c)
+            {
+                const double* t = templates.data() + (size_t) c * 12;
+                double sum = 0.0;
+                for (int i = 0; i < 12; ++i)
+                    sum += t[i] * x[i];
+                out[c] = sum;
+            }
+        }
+    }
+
+    // Viterbi with a uniform change penalty: the best predecessor of any
+    // state is either itself or the overall best state minus the penalty
+    std::vector<double> pathScore (scores.begin(), scores.begin() + numChords);
+    std::vector<int> backPointer ((size_t) numObs * (size_t) numChords, 0);
+    for (int o = 1; o < numObs; ++o)
+    {
+        int bestPrev = (int) (std::max_element (pathScore.begin(), pathScore.end()) - pathScore.begin());
+        double switchScore = pathScore[(size_t) bestPrev] - (double) chordChangePenalty;
+        const double* obs = scores.data() + (size_t) o * (size_t) numChords;
+        int* back = backPointer.data() + (size_t) o * (size_t) numChords;
+
+        for (int c = 0; c < numChords; ++c)
+        {
+            bool stay = pathScore[(size_t) c] >= switchScore;
+            back[c] = stay ? c : bestPrev;
+            pathScore[(size_t) c] = (stay ? pathScore[(size_t) c] : switchScore) + obs[c];
+        }
+    }
+
+    std::vector<int> path ((size_t) numObs);
+    path.back() = (int) (std::max_element (pathScore.begin(), pathScore.end()) - pathScore.begin());
+    for (int o = numObs - 1; o > 0; --o)
+        path[(size_t) o - 1] = backPointer[(size_t) o * (size_t) numChords + (size_t) path[(size_t) o]];
+
+    // Merge runs of the same chord; a silent / skipped gap ends an event
+    for (int o = 0; o < numObs; )
+    {
+        int chord = path[(size_t) o];
+        int end = o + 1;
+        double scoreSum = scores[(size_t) o * (size_t) numChords + (size_t) chord];
+        while (end < numObs && path[(size_t) end] == chord
+               && voicedFrames[(size_t) end] == voicedFrames[(size_t) end - 1] + 1)
+            scoreSum += scores[(size_t) end++ * (size_t) numChords + (size_t) chord];
+
+        const auto& t = CHORD_TEMPLATES[chord % NUM_CHORD_QUALITIES];
+        ChordEvent ev;
+        ev.startSeconds = voicedFrames[(size_t) o] * hopSeconds;
+        ev.endSeconds   = (voicedFrames[(size_t) end - 1] + 1) * hopSeconds;
+        ev.root         = chord / NUM_CHORD_QUALITIES;
+        ev.quality      = t.quality;
+        ev.name         = juce::String (NOTE_NAMES[ev.root]) + juce::String::fromUTF8 (t.suffix);
+        ev.score        = (float) (scoreSum / (end - o));
+        events.push_back (ev);
+        o = end;
+    }
+
+    return events;
+}
+
+// ── Beat tracking ────────────────────────────────────────────────────────
+// Ellis (2007) dynamic programming: the best score ending on a beat at frame
+// t is onset[t] plus the best predecessor score penalised by
+// tightness · log²(interval / period). Backtracking from the best final
+// frame gives beats that sit on strong onsets while keeping a near-constant
+// spacing.
+std::vector<int> AudioAnalyzer::trackBeatFrames (const float* onset, int numFrames, double periodFrames) const
+{
+    std::vector<int> beats;
+    const int n = numFrames;
+    if (n == 0 || periodFrames < 2.0)
+        return beats;
+
+    // Normalise the envelope by its standard deviation so tightness has a
+    // consistent scale across tracks
+    double mean = 0.0, var = 0.0;
+    for (int t = 0; t < n; ++t) mean += onset[t];
+    mean /= n;
+    for (int t = 0; t < n; ++t) var += (onset[t] - mean) * (onset[t] - mean);
+    double stdDev = std::sqrt (var / n);
+    if (stdDev <= 0.0)
+        return beats;
+
+    const int minLag = juce::jmax (1, (int) std::round (periodFrames * 0.5));
+    const int maxLag = juce::jmax (minLag, (int) std::round (periodFrames * 2.0));
+    std::vector<double> transition ((size_t) (maxLag + 1), 0.0);
+    for (int d = minLag; d <= maxLag; ++d)
+    {
+        double l = std::log ((double) d / periodFrames);
+        transition[(size_t) d] = -(double) beatTightness * l * l;
+    }
+
+    std::vector<double> score ((size_t) n);
+    std::vector<int> backLink ((size_t) n, -1);
+    for (int t = 0; t < n; ++t)
+    {
+        double best = 0.0;
+        int bestFrom = -1;
+        for (int d = minLag; d <= maxLag && d <= t; ++d)
+        {
+            double s = score[(size_t) (t - d)] + transition[(size_t) d];
+            if (s > best) { best = s; bestFrom = t - d; }
+        }
+        // A chain starts afresh wherever no predecessor adds positive score
+        score[(size_t) t] = (double) onset[t] / stdDev + best;
+        backLink[(size_t) t] = bestFrom;
+    }
+
+    // End on the best-scoring frame within the final period
+    int last = n - 1;
+    for (int t = juce::jmax (0, n - (int) std::ceil (periodFrames)); t < n; ++t)
+        if (score[(size_t) t] > score[(size_t) last]) last = t;
+
+    for (int t = last; t >= 0; t = backLink[(size_t) t])
+        beats.push_back (t);
+    std::reverse (beats.begin(), beats.end());
+    return beats;
+}
+
+// ── Meter ────────────────────────────────────────────────────────────────
+// Bar length from the autocorrelation of beat-synchronous accents (bass
+// onsets weighted double, since kicks mark bars): 4/4 repeats at 2 and 4
+// beats, 3/4 at 3. A ternary beat subdivision in the frame-level tempo
+// autocorrelation (peaks at P/3, 2P/3 rather than P/2) with a two-beat bar
+// reads as 6/8. The downbeat is the bar slot with the strongest accents.
+void AudioAnalyzer::estimateMeter (const float* fullEnv, const float* bassEnv, int numFrames,
+                                   std::vector<float> fullAC, Autocorrelator& autocorrelator,
+                                   const std::vector<int>& beatFrames, double periodFrames, BeatGrid& grid)
+{
+    const int numBeats = (int) beatFrames.size();
+    const int n = numFrames;
+    if (numBeats < 8 || n == 0)
+        return;
+
+    // Accent per beat: peak of each envelope within ±2 frames, each envelope
+    // scaled by its mean so neither band dominates by level alone
+    auto meanOf = [n] (const float* env)
+    {
+        double sum = 0.0;
+        for (int i = 0; i < n; ++i) sum += env[i];
+        return sum > 0.0 ? sum / n : 1.0;
+    };
+    const double fullMean = meanOf (fullEnv), bassMean = meanOf (bassEnv);
+
+    std::vector<float> accent ((size_t) numBeats);
+    for (int b = 0; b < numBeats; ++b)
+    {
+        float fullPeak = 0.0f, bassPeak = 0.0f;
+        for (int f = juce::jmax (0, beatFrames[(size_t) b] - 2); f <= juce::jmin (n - 1, beatFrames[(size_t) b] + 2); ++f)
+        {
+            fullPeak = juce::jmax (fullPeak, fullEnv[f]);
+            bassPeak = juce::jmax (bassPeak, bassEnv[f]);
+        }
+        accent[(size_t) b] = (float) (fullPeak / fullMean + 2.0 * bassPeak / bassMean);
+    }
+
+    // Bar-level periodicity: normalised autocorrelation of the centred accents
+    std::vector<float> centred (accent);
+    double accentMean = 0.0;
+    for (float a : accent) accentMean += a;
+    accentMean /= numBeats;
+    for (auto& a : centred) a -= (float) accentMean;
+
+    // Only lags 0-4 are needed, so direct sums beat an FFT here
+    float barAC[5] = {};
+    for (int lag = 0; lag <= 4; ++lag)
+        for (int b = 0; b + lag < numBeats; ++b)
+            barAC[lag] += centred[(size_t) b] * centred[(size_t) (b + lag)];
+    auto barCorr = [&] (int lag)
+    {
+        return barAC[0] > 0.0f ? (barAC[lag] / (float) (numBeats - lag)) / (barAC[0] / (float) numBeats) : 0.0f;
+    };
+
+    // Beat subdivision from the frame-level autocorrelation
+    const int subLag = (int) std::ceil (periodFrames) + 1;
+    if ((int) fullAC.size() <= subLag)
+    {
+        autocorrelator.prepare (n, subLag);
+        fullAC = autocorrelator.process (fullEnv, n);
+    }
+    auto acAt = [&] (double lag)
+    {
+        int i = (int) lag;
+        if (i + 1 >= (int) fullAC.size()) return 0.0f;
+        float frac = (float) (lag - i);
+        return ((1.0f - frac) * fullAC[(size_t) i] + frac * fullAC[(size_t) (i + 1)]) / (float) (n - i);
+    };
+    float ternary = 0.5f * (acAt (periodFrames / 3.0) + acAt (periodFrames * 2.0 / 3.0));
+    float binary  = acAt (periodFrames / 2.0);
+
+    if (ternary > binary && barCorr (2) >= barCorr (3))
+    {
+        grid.meter = "6/8";
+        grid.beatsPerBar = 2;
+    }
+    else if (barCorr (3) > barCorr (4) && barCorr (3) > barCorr (2))
+    {
+        grid.meter = "3/4";
+        grid.beatsPerBar = 3;
+    }
+    else
+    {
+        grid.meter = "4/4";
+        grid.beatsPerBar = 4;
+    }
+
+    std::vector<double> slotAccent ((size_t) grid.beatsPerBar, 0.0);
+    for (int b = 0; b < numBeats; ++b)
+        slotAccent[(size_t) (b % grid.beatsPerBar)] += accent[(size_t) b];
+    grid.firstDownbeat = (int) (std::max_element (slotAccent.begin(), slotAccent.end()) - slotAccent.begin());
+}
+
+// ── Level descriptors ────────────────────────────────────────────────────
+// Integrated loudness per ITU-R BS.1770-4: K-weighting (shelf + high-pass
+// biquads, coefficients re-derived for the file rate as in libebur128),
+// 400 ms blocks at 75% overlap, −70 LUFS absolute and −10 LU relative gates.
+// True peak uses 4× polyphase interpolation (12-tap Hann-windowed sinc per
+// phase). Channels run in parallel; all channels are weighted 1.0.
+AudioAnalyzer::Descriptors AudioAnalyzer::measureLevels (const juce::AudioBuffer<float>& buffer,
+                                                         double sampleRate)
+{
+    Descriptors result;
+    const int numChannels = buffer.getNumChannels();
+    const int numSamples  = buffer.getNumSamples();
+    if (numChannels <= 0 || numSamples <= 0 || sampleRate <= 0.0)
+        return result;
+
+    struct Biquad { double b0, b1, b2, a1, a2; };
+    Biquad shelf, highPass;
+    {
+        double k  = std::tan (M_PI * 1681.974450955533 / sampleRate);
+        double q  = 0.7071752369554196;
+        double vh = std::pow (10.0, 3.999843853973347 / 20.0);
+        double vb = std::pow (vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+        shelf = { (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                  2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+    }
+    {
+        double k  = std::tan (M_PI * 38.13547087602444 / sampleRate);
+        double q  = 0.5003270373238773;
+        double a0 = 1.0 + k / q + k * k;
+        highPass = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+    }
+
+    // True-peak interpolator: taps[p][j] weights x[n + j - 5] for the point n + p/4
+    float taps[4][12];
+    for (int p = 0; p < 4; ++p)
+    {
+        for (int j = 0; j < 12; ++j)
+        {
+            double u = (double) p / 4.0 - (double) (j - 5);
+            double sinc = std::abs (u) < 1.0e-9 ? 1.0 : std::sin (M_PI * u) / (M_PI * u);
+            taps[p][j] = (float) (sinc * 0.5 * (1.0 + std::cos (M_PI * u / 6.0)));
+        }
+    }
+
+    // 100 ms segments: four consecutive ones form a 400 ms gating block
+    const int segmentLength = juce::jmax (1, (int) std::round (sampleRate * 0.1));
+    const int numSegments   = numSamples / segmentLength;
+
+    struct ChannelLevels { std::vector<double> segmentEnergy; double sumSquares = 0.0; float peak = 0.0f, truePeak = 0.0f; };
+    std::vector<ChannelLevels> channels ((size_t) numChannels);
+
+    parallelFor (numChannels, [&] (int ch)
+    {
+        auto& levels = channels[(size_t) ch];
+        levels.segmentEnergy.assign ((size_t) numSegments, 0.0);
+        const float* x = buffer.getReadPointer (ch);
+
+        // Direct form I state: x1/x2 inputs, y1/y2 outputs of each stage
+        double sx1 = 0, sx2 = 0, sy1 = 0, sy2 = 0;
+        double hy1 = 0, hy2 = 0;
+        for (int n = 0; n < numSamples; ++n)
+        {
+            if ((n & 0xffff) == 0 && threadShouldExit()) return;
+
+            double in = (double) x[n];
+            double shelved = shelf.b0 * in + shelf.b1 * sx1 + shelf.b2 * sx2 - shelf.a1 * sy1 - shelf.a2 * sy2;
+            double weighted = highPass.b0 * shelved + highPass.b1 * sy1 + highPass.b2 * sy2
+                              - highPass.a1 * hy1 - highPass.a2 * hy2;
+            sx2 = sx1; sx1 = in; sy2 = sy1; sy1 = shelved;
+            hy2 = hy1; hy1 = weighted;
+
+            int segment = n / segmentLength;
+            if (segment < numSegments)
+                levels.segmentEnergy[(size_t) segment] += weighted * weighted;
+
+            levels.sumSquares += in * in;
+            levels.peak = juce::jmax (levels.peak, std::abs (x[n]));
+
+            if (n >= 5 && n + 6 < numSamples)
+            {
+                for (int p = 1; p < 4; ++p)
+                {
+                    float v = 0.0f;
+                    for (int j = 0; j < 12; ++j)
+                        v += taps[p][j] * x[n + j - 5];
+                    levels.truePeak = juce::jmax (levels.truePeak, std::abs (v));
+                }
+            }
+        }
+        levels.truePeak = juce::jmax (levels.truePeak, levels.peak);
+    });
+
+    if (threadShouldExit())
+        return result;
+
+    // Gated integration over 400 ms blocks
+    std::vector<double> blockEnergy;
+    for (int seg = 0; seg + 4 <= numSegments; ++seg)
+    {
+        double z = 0.0;
+        for (const auto& levels : channels)
+            for (int k = 0; k < 4; ++k)
+                z += levels.segmentEnergy[(size_t) (seg + k)];
+        blockEnergy.push_back (z / (4.0 * segmentLength));
+    }
+
+    auto loudnessOf = [] (double z) { return -0.691 + 10.0 * std::log10 (juce::jmax (z, 1.0e-12)); };
+    auto gatedMean = [&] (double gateLUFS)
+    {
+        double sum = 0.0;
+        int count = 0;
+        for (double z : blockEnergy)
+            if (loudnessOf (z) > gateLUFS) { sum += z; ++count; }
+        return count > 0 ? sum / count : 0.0;
+    };
+
+    double absoluteMean = gatedMean (-70.0);
+    if (absoluteMean > 0.0)
+    {
+        double relativeMean = gatedMean (loudnessOf (absoluteMean) - 10.0);
+        if (relativeMean > 0.0)
+            result.integratedLoudnessLUFS = (float) loudnessOf (relativeMean);
+    }
+
+    double sumSquares = 0.0;
+    float peak = 0.0f, truePeak = 0.0f;
+    for (const auto& levels : channels)
+    {
+        sumSquares += levels.sumSquares;
+        peak     = juce::jmax (peak, levels.peak);
+        truePeak = juce::jmax (truePeak, levels.truePeak);
+    }
+    double rms = std::sqrt (sumSquares / ((double) numChannels * numSamples));
+
+    result.samplePeakDBFS = juce::Decibels::gainToDecibels (peak);
+    result.truePeakDBTP   = juce::Decibels::gainToDecibels (truePeak);
+    result.crestFactorDB  = rms > 0.0 ? (float) (20.0 * std::log10 ((double) peak / rms)) : 0.0f;
+    return result;
+}
+
+void AudioAnalyzer::parallelFor (int numTasks, const std::function<void (int)>& task)
+{
+    // Tasks are claimed dynamically; each index runs exactly once
+    std::atomic<int> nextTask { 0 };
+    auto drainTasks = [&]
+    {
+        for (int t = nextTask++; t < numTasks; t = nextTask++)
+            task (t);
+    };
+
+    int numHelpers = juce::jmin (workerPool.getNumThreads(), numTasks - 1);
+    std::atomic<int> helpersRunning { numHelpers };
+    juce::WaitableEvent helpersDone;
+
+    for (int h = 0; h < numHelpers; ++h)
+    {
+        workerPool.addJob ([&]
+        {
+            drainTasks();
+            if (--helpersRunning == 0)
+                helpersDone.signal();
+        });
+    }
+
+    drainTasks();
+
+    if (numHelpers > 0)
+        helpersDone.wait();
 }
 
 void AudioAnalyzer::run()
@@ -289,6 +1259,12 @@ void AudioAnalyzer::run()
 
     if (threadShouldExit()) return;
 
+    // Level descriptors need the original channels and rate, so measure them
+    // before the mixdown; the spectral centroid is filled in by the BPM pass
+    Descriptors levels = measureLevels (fileBuffer, fileSampleRate);
+
+    if (threadShouldExit()) return;
+
     // ── 3. Convert to mono ───────────────────────────────────────────────
     juce::AudioBuffer<float> monoBuffer (1, numSamples);
 
@@ -313,34 +1289,44 @@ void AudioAnalyzer::run()
 
     if (std::abs (fileSampleRate - targetSampleRate) > 1.0)
     {
+        // process() returns the input samples it consumed, not the output
+        // count; rounding the output length down keeps it within the input
         double ratio = fileSampleRate / targetSampleRate;
-        int outputLength = (int) ((double) numSamples / ratio) + 1;
+        int outputLength = (int) ((double) numSamples / ratio);
         resampledBuffer.setSize (1, outputLength);
 
         juce::LagrangeInterpolator interpolator;
-        int produced = interpolator.process (ratio,
-                                              monoBuffer.getReadPointer (0),
-                                              resampledBuffer.getWritePointer (0),
-                                              outputLength);
+        interpolator.process (ratio,
+                              monoBuffer.getReadPointer (0),
+                              resampledBuffer.getWritePointer (0),
+                              outputLength);
 
         analysisSamples = resampledBuffer.getReadPointer (0);
-        analysisSampleCount = produced;
+        analysisSampleCount = outputLength;
 
         DBG ("AudioAnalyzer: Resampled from " + juce::String (fileSampleRate)
              + " to " + juce::String (targetSampleRate)
              + " (" + juce::String (analysisSampleCount) + " samples)");
     }
 
+    // Optional centred excerpt: timestamps below are shifted back by its offset
+    double excerptOffsetSeconds = 0.0;
+    if (maxAnalysisSeconds > 0.0f)
+    {
+        int maxSamples = (int) ((double) maxAnalysisSeconds * targetSampleRate);
+        if (analysisSampleCount > maxSamples)
+        {
+            int start = (analysisSampleCount - maxSamples) / 2;
+            analysisSamples += start;
+            analysisSampleCount = maxSamples;
+            excerptOffsetSeconds = (double) start / targetSampleRate;
+        }
+    }
+
     if (threadShouldExit()) return;
 
     // ── 5. Chromagram via semitone filterbank ───────────────────────────
-    audiofft::AudioFFT fft;
-    fft.init ((size_t) fftSize);
-
     size_t complexSize = audiofft::AudioFFT::ComplexSize ((size_t) fftSize);
-    std::vector<float> windowedBuf ((size_t) fftSize);
-    std::vector<float> re (complexSize);
-    std::vector<float> im (complexSize);
 
     // Pre-compute Hann window
     std::vector<float> hannWindow ((size_t) fftSize);
@@ -350,26 +1336,164 @@ void AudioAnalyzer::run()
     // Chromagram accumulator (12 pitch classes)
     double chroma[12] = {};
 
-    int hopSize = fftSize / 2;
+    int hopSize = juce::jmax (1, (int) ((float) fftSize * hopFraction));
     int minBin = (int) std::ceil ((double) minFreqHz * fftSize / targetSampleRate);
     int maxBin = (int) std::floor ((double) maxFreqHz * fftSize / targetSampleRate);
     maxBin = juce::jmin (maxBin, (int) complexSize - 1);
 
-    // Pre-compute magnitudes buffer
-    std::vector<float> magnitudes (complexSize, 0.0f);
+    const bool useConstantQ = (chromaFrontEnd == ChromaFrontEnd::constantQ);
+    int numChromaFrames = analysisSampleCount >= fftSize
+                              ? (analysisSampleCount - fftSize) / hopSize + 1 : 0;
+
+    // Per-task FFT scratch — each task owns one, so workers never share buffers
+    struct ChromaScratch
+    {
+        audiofft::AudioFFT fft;
+        std::vector<float> windowedBuf, re, im, magnitudes, cq;
+
+        void prepare (int size, size_t bins, int cqBins)
+        {
+            fft.init ((size_t) size);
+            windowedBuf.resize ((size_t) size);
+            re.resize (bins);
+            im.resize (bins);
+            magnitudes.assign (bins, 0.0f);
+            cq.assign ((size_t) cqBins, 0.0f);
+        }
+    };
+
+    // FFT + Hann-windowed magnitudes for the frame at pos; false for silent
+    // frames, which are never analysed. With rawSpectrum set, re/im keep the
+    // unwindowed transform the constant-Q kernel is built for, and the window
+    // is applied to the magnitudes in the frequency domain instead:
+    //     Hann(X)[k] = 0.5·X[k] − 0.25·(X[k−1] + X[k+1])
+    // so HPSS, the flatness gate and the bass chroma still see low-leakage
+    // spectra without a second FFT.
+    const auto kernels = framekernels::forSize (fftSize);
+
+    auto computeSpectrum = [&] (ChromaScratch& scratch, int pos, bool rawSpectrum) -> bool
+    {
+        const float* chunk = analysisSamples + pos;
+
+        // Check RMS amplitude — skip silence
+        float sumSq = kernels.sumOfSquares (chunk, fftSize);
+        float rms = std::sqrt (sumSq / (float) fftSize);
+
+        if (rms < amplitudeThreshold)
+            return false;
+
+        if (! rawSpectrum)
+        {
+            kernels.applyWindow (chunk, hannWindow.data(), scratch.windowedBuf.data(), fftSize);
+            scratch.fft.fft (scratch.windowedBuf.data(), scratch.re.data(), scratch.im.data());
+
+            // Pre-compute all bin magnitudes
+            kernels.magnitudes (scratch.re.data(), scratch.im.data(), scratch.magnitudes.data(), (int) complexSize);
+            return true;
+        }
+
+        scratch.fft.fft (chunk, scratch.re.data(), scratch.im.data());
+
+        // Neighbours past DC and Nyquist are the complex conjugates of the
+        // bins inside (real input)
+        const auto& re = scratch.re;
+        const auto& im = scratch.im;
+        const int last = (int) complexSize - 1;
+        for (int b = 0; b <= last; ++b)
+        {
+            float reLeft  = b > 0    ? re[(size_t) b - 1] : re[1];
+            float imLeft  = b > 0    ? im[(size_t) b - 1] : -im[1];
+            float reRight = b < last ? re[(size_t) b + 1] : re[(size_t) last - 1];
+            float imRight = b < last ? im[(size_t) b + 1] : -im[(size_t) last - 1];
+            float wr = 0.5f * re[(size_t) b] - 0.25f * (reLeft + reRight);
+            float wi = 0.5f * im[(size_t) b] - 0.25f * (imLeft + imRight);
+            scratch.magnitudes[(size_t) b] = std::sqrt (wr * wr + wi * wi);
+        }
+        return true;
+    };
+
+    // ── Reference tuning estimate ──
+    // Circular mean of the fractional-semitone offsets of spectral peaks in the
+    // first voiced frames. Their magnitude spectra are kept so the main pass
+    // doesn't transform them twice (filterbank front end only — the
+    // constant-Q front end needs the unwindowed spectrum).
+    double referenceHz = 440.0;
+    std::vector<std::vector<float>> cachedSpectra;   // Per leading frame; empty = silent
+
+    if (estimateTuning && numChromaFrames > 0)
+    {
+        ChromaScratch scratch;
+        scratch.prepare (fftSize, complexSize, 0);
+
+        // Bass bins are too coarse for sub-semitone offsets, so start at 250 Hz
+        int tuneMinBin = juce::jmax (2, minBin, (int) std::ceil (250.0 * fftSize / targetSampleRate));
+        int tuneMaxBin = juce::jmin (maxBin, (int) complexSize - 2);
+        double sumCos = 0.0, sumSin = 0.0, sumWeight = 0.0;
+        int voicedFrames = 0;
+
+        for (int f = 0; f < numChromaFrames && voicedFrames < tuningFrames; ++f)
+        {
+            if (threadShouldExit()) return;
+
+            bool voiced = computeSpectrum (scratch, f * hopSize, false);
+            if (! useConstantQ)
+                cachedSpectra.push_back (voiced ? scratch.magnitudes : std::vector<float>());
+            if (! voiced) continue;
+            ++voicedFrames;
+
+            const auto& mag = scratch.magnitudes;
+            float framePeak = *std::max_element (mag.begin() + tuneMinBin, mag.begin() + tuneMaxBin + 1);
+
+            for (int bin = tuneMinBin; bin <= tuneMaxBin; ++bin)
+            {
+                float m = mag[(size_t) bin];
+                if (m < framePeak * 0.1f || m <= mag[(size_t) bin - 1] || m < mag[(size_t) bin + 1])
+                    continue;
+
+                // Parabolic interpolation on log magnitude for the true peak position
+                double a = std::log ((double) mag[(size_t) bin - 1] + 1.0e-9);
+                double b = std::log ((double) m + 1.0e-9);
+                double c = std::log ((double) mag[(size_t) bin + 1] + 1.0e-9);
+                double denom = a - 2.0 * b + c;
+                double delta = denom < 0.0 ? 0.5 * (a - c) / denom : 0.0;
+
+                double freq = ((double) bin + delta) * targetSampleRate / fftSize;
+                double semis = hzToFractionalMidi (freq, 440.0);
+                double phase = 2.0 * M_PI * (semis - std::round (semis));
+                sumCos += (double) m * std::cos (phase);
+                sumSin += (double) m * std::sin (phase);
+                sumWeight += (double) m;
+            }
+        }
+
+        // Only trust a concentrated offset distribution
+        double resultant = sumWeight > 0.0 ? std::sqrt (sumCos * sumCos + sumSin * sumSin) / sumWeight : 0.0;
+        if (resultant > 0.2)
+        {
+            double offsetSemis = std::atan2 (sumSin, sumCos) / (2.0 * M_PI);
+            referenceHz = 440.0 * std::pow (2.0, offsetSemis / 12.0);
+        }
+
+        DBG ("AudioAnalyzer: Reference tuning A4 = " + juce::String (referenceHz, 2)
+             + " Hz (resultant " + juce::String (resultant, 2) + ")");
+    }
+
+    {
+        const juce::ScopedLock sl (resultLock);
+        detectedTuningHz = (float) referenceHz;
+    }
 
     // ── Pre-compute semitone filterbank ──
     // For each MIDI note (C1=24 to B7=107), find the FFT bin range
-    // covering ±0.5 semitones around the note's center frequency.
+    // covering ±0.5 semitones around the note's center frequency,
+    // re-centred on the estimated reference tuning.
     // All octaves fold into 12 pitch classes.
-    // Semitone filterbank: for each MIDI note, store the FFT bin range
-    // covering ±0.5 semitones. All octaves fold into 12 pitch classes.
     struct ChromaBand { int lowBin; int highBin; int pitchClass; };
     std::vector<ChromaBand> filterbank;
 
     for (int midi = 24; midi <= 107; ++midi)
     {
-        double centerFreq = 440.0 * std::pow (2.0, (double) (midi - 69) / 12.0);
+        double centerFreq = midiToHz ((double) midi, referenceHz);
         double lowFreq  = centerFreq * std::pow (2.0, -1.0 / 24.0);
         double highFreq = centerFreq * std::pow (2.0,  1.0 / 24.0);
 
@@ -387,51 +1511,60 @@ void AudioAnalyzer::run()
     DBG ("AudioAnalyzer: Filterbank has " + juce::String ((int) filterbank.size())
          + " bands across " + juce::String (minFreqHz, 0) + "-" + juce::String (maxFreqHz, 0) + " Hz");
 
-    for (int pos = 0; pos + fftSize <= analysisSampleCount; pos += hopSize)
+    if (useConstantQ)
     {
-        if (threadShouldExit()) return;
-
-        const float* chunk = analysisSamples + pos;
-
-        // Check RMS amplitude — skip silence
-        float sumSq = 0.0f;
-        for (int i = 0; i < fftSize; ++i)
-            sumSq += chunk[i] * chunk[i];
-        float rms = std::sqrt (sumSq / (float) fftSize);
-
-        if (rms < amplitudeThreshold)
-            continue;
-
-        // Apply Hann window
-        for (int i = 0; i < fftSize; ++i)
-            windowedBuf[(size_t) i] = chunk[i] * hannWindow[(size_t) i];
+        buildConstantQKernel (cqtKernel, fftSize, targetSampleRate, minFreqHz, maxFreqHz,
+                              cqtBinsPerSemitone >= 3 ? 3 : 1, referenceHz);
+        filterbank.clear();   // Constant-Q bins replace the linear-FFT bands
+    }
 
-        // Compute FFT
-        fft.fft (windowedBuf.data(), re.data(), im.data());
+    // HPSS covers every bin the chroma stage reads (peak neighbours included)
+    const bool useHPSS = separateHarmonics;
+    int hpssBins = juce::jmin ((int) complexSize, maxBin + 2);
+    if (useConstantQ && ! cqtKernel.fftBin.empty())
+        hpssBins = juce::jmax (hpssBins, *std::max_element (cqtKernel.fftBin.begin(), cqtKernel.fftBin.end()) + 1);
+
+    // ── Bass chroma map ──
+    // Each linear-FFT bin in the bass band folds to its nearest pitch class.
+    // Bass semitones are narrower than a bin, so per-bin assignment keeps
+    // every bass note instead of dropping bands that contain no bin.
+    int bassMinBin = juce::jmax (1, (int) std::ceil  ((double) bassMinHz * fftSize / targetSampleRate));
+    int bassMaxBin = juce::jmin ((int) complexSize - 2,
+                                 (int) std::floor ((double) bassMaxHz * fftSize / targetSampleRate));
+    std::vector<int> bassPitchClass;
+    for (int bin = bassMinBin; bin <= bassMaxBin; ++bin)
+    {
+        double freq = (double) bin * targetSampleRate / fftSize;
+        bassPitchClass.push_back (hzToPitchClass ((float) freq, referenceHz));
+    }
 
-        // Pre-compute all bin magnitudes
-        for (int bin = 0; bin < (int) complexSize; ++bin)
-            magnitudes[(size_t) bin] = std::sqrt (re[(size_t) bin] * re[(size_t) bin]
-                                                + im[(size_t) bin] * im[(size_t) bin]);
+    // Turns the spectrum in scratch into frameChroma (L2-normalised) and the
+    // bass-band frameBass (L2-normalised, or all zero when the bass is empty).
+    // Returns false for percussive frames that must not contribute.
+    auto chromaFromSpectrum = [&] (ChromaScratch& scratch, double* frameChroma, double* frameBass) -> bool
+    {
+        const auto& magnitudes = scratch.magnitudes;
 
         // ── Percussive frame filtering via spectral flatness ──
-        // High flatness = energy spread evenly = noise/percussion → skip
+        // High flatness = energy spread evenly = noise/percussion → skip.
+        // With HPSS the percussive energy is already masked out instead.
+        if (! useHPSS)
         {
             double logSum = 0.0, linSum = 0.0;
             int flatCount = 0;
             for (int bin = minBin; bin <= maxBin; ++bin)
             {
                 float mag = magnitudes[(size_t) bin];
-                if (mag > 0.0f) { logSum += std::log ((double) mag); flatCount++; }
+                if (mag > 0.0f) { logSum += (double) fastmath::log2 (mag); flatCount++; }
                 linSum += (double) mag;
             }
             if (flatCount > 0)
             {
-                double geoMean = std::exp (logSum / flatCount);
+                double geoMean = (double) fastmath::exp2 ((float) (logSum / flatCount));
                 double ariMean = linSum / flatCount;
                 double flatness = (ariMean > 0.0) ? geoMean / ariMean : 0.0;
                 if (flatness > 0.8)
-                    continue;  // skip percussive/noisy frame
+                    return false;  // skip percussive/noisy frame
             }
         }
 
@@ -439,7 +1572,41 @@ void AudioAnalyzer::run()
         // Only accumulate spectral peaks (local maxima) into pitch classes.
         // This focuses on tonal content and removes broadband energy that
         // can bias the chromagram toward non-tonic pitch classes.
-        double frameChroma[12] = {};
+        for (int i = 0; i < 12; ++i)
+            frameChroma[i] = 0.0;
+
+        if (useConstantQ)
+        {
+            // Sparse kernel product: one short dot product per log-spaced bin
+            auto& cq = scratch.cq;
+            for (int k = 0; k < cqtKernel.numBins(); ++k)
+            {
+                float sumRe = 0.0f, sumIm = 0.0f;
+                for (int e = cqtKernel.rowStart[(size_t) k]; e < cqtKernel.rowStart[(size_t) k + 1]; ++e)
+                {
+                    float xr = scratch.re[(size_t) cqtKernel.fftBin[(size_t) e]];
+                    float xi = scratch.im[(size_t) cqtKernel.fftBin[(size_t) e]];
+                    float kr = cqtKernel.re[(size_t) e], ki = cqtKernel.im[(size_t) e];
+                    sumRe += xr * kr - xi * ki;
+                    sumIm += xr * ki + xi * kr;
+                }
+                cq[(size_t) k] = std::sqrt (sumRe * sumRe + sumIm * sumIm);
+            }
+
+            // Same peak/prominence weighting as the filterbank, along the
+            // log-frequency axis (every bin counts at 1 bin per semitone)
+            bool pickPeaks = cqtKernel.binsPerSemitone > 1;
+            for (int k = 0; k < cqtKernel.numBins(); ++k)
+            {
+                double mag = (double) cq[(size_t) k];
+                double lower = k > 0 ? (double) cq[(size_t) k - 1] : 0.0;
+                double upper = k + 1 < cqtKernel.numBins() ? (double) cq[(size_t) k + 1] : 0.0;
+                if (! pickPeaks)
+                    frameChroma[cqtKernel.pitchClass[(size_t) k]] += mag * mag;
+                else if (mag > lower && mag >= upper)
+                    frameChroma[cqtKernel.pitchClass[(size_t) k]] += mag * (mag - juce::jmax (lower, upper));
+            }
+        }
 
         for (const auto& band : filterbank)
         {
@@ -467,7 +1634,7 @@ void AudioAnalyzer::run()
         // Log compression — reduces dynamic range so loud partials
         // don't dominate the pitch class distribution
         for (int i = 0; i < 12; ++i)
-            frameChroma[i] = std::log1p (frameChroma[i]);
+            frameChroma[i] = (double) fastmath::log1p ((float) frameChroma[i]);
 
         // ── Per-frame L2 normalization ──
         // Every frame contributes equally regardless of volume
@@ -476,47 +1643,217 @@ void AudioAnalyzer::run()
             norm += frameChroma[i] * frameChroma[i];
         norm = std::sqrt (norm);
 
-        if (norm > 0.0)
+        if (norm <= 0.0)
+            return false;
+
+        for (int i = 0; i < 12; ++i)
+            frameChroma[i] /= norm;
+
+        // ── Bass chroma from the same magnitudes (bins already in cache) ──
+        for (int i = 0; i < 12; ++i)
+            frameBass[i] = 0.0;
+        for (int bin = bassMinBin; bin <= bassMaxBin; ++bin)
+        {
+            float mag = magnitudes[(size_t) bin];
+            float left = magnitudes[(size_t) bin - 1], right = magnitudes[(size_t) bin + 1];
+            if (mag > left && mag >= right)
+                frameBass[bassPitchClass[(size_t) (bin - bassMinBin)]] += (double) mag * (double) (mag - juce::jmax (left, right));
+        }
+
+        double bassNorm = 0.0;
+        for (int i = 0; i < 12; ++i)
+        {
+            frameBass[i] = (double) fastmath::log1p ((float) frameBass[i]);
+            bassNorm += frameBass[i] * frameBass[i];
+        }
+        bassNorm = std::sqrt (bassNorm);
+        if (bassNorm > 0.0)
+            for (int i = 0; i < 12; ++i)
+                frameBass[i] /= bassNorm;
+
+        return true;
+    };
+
+    // ── Frame-parallel pass ──
+    // Frames are independent, so contiguous frame ranges run on the worker
+    // pool. Each frame writes its own slot; the reduction below then sums in
+    // frame order, making the result bit-identical to a single-threaded run.
+    std::vector<double> frameChromas ((size_t) numChromaFrames * 12, 0.0);
+    std::vector<double> frameBassChromas ((size_t) numChromaFrames * 12, 0.0);
+    std::vector<uint8_t> frameVoiced ((size_t) numChromaFrames, 0);
+
+    int numChromaTasks = juce::jmax (1, juce::jmin (workerPool.getNumThreads() + 1, numChromaFrames));
+    std::vector<ChromaScratch> chromaScratch ((size_t) numChromaTasks);
+
+    parallelFor (numChromaTasks, [&] (int task)
+    {
+        auto& scratch = chromaScratch[(size_t) task];
+        scratch.prepare (fftSize, complexSize, cqtKernel.numBins());
+
+        int firstFrame = (int) ((int64_t) numChromaFrames * task / numChromaTasks);
+        int endFrame   = (int) ((int64_t) numChromaFrames * (task + 1) / numChromaTasks);
+
+        // Magnitudes (and re/im unless cached) for frame f; false = silent
+        auto loadSpectrum = [&] (int f) -> bool
+        {
+            if (f < (int) cachedSpectra.size())
+            {
+                const auto& cached = cachedSpectra[(size_t) f];
+                if (cached.empty()) return false;
+                std::copy (cached.begin(), cached.end(), scratch.magnitudes.begin());
+                return true;
+            }
+            return computeSpectrum (scratch, f * hopSize, useConstantQ);
+        };
+
+        if (! useHPSS)
+        {
+            for (int f = firstFrame; f < endFrame; ++f)
+            {
+                if (threadShouldExit()) return;
+                frameVoiced[(size_t) f] = loadSpectrum (f)
+                                          && chromaFromSpectrum (scratch, frameChromas.data() + (size_t) f * 12,
+                                                                 frameBassChromas.data() + (size_t) f * 12)
+                                              ? 1 : 0;
+            }
+            return;
+        }
+
+        // HPSS: stream from `latency` frames before the range to `latency`
+        // frames past it, so every frame sees the same centred time window
+        // whichever task processes it (results stay independent of threading)
+        HarmonicSeparator separator;
+        separator.prepare (hpssBins, juce::jmax (1, hpssTimeFrames | 1), juce::jmax (1, hpssFreqBins | 1),
+                           useConstantQ);
+        int latency = separator.latency();
+        std::vector<uint8_t> pendingVoiced ((size_t) latency + 1, 0);
+
+        for (int g = juce::jmax (0, firstFrame - latency); g < endFrame + latency; ++g)
+        {
+            if (threadShouldExit()) return;
+
+            bool voiced = g < numChromaFrames && loadSpectrum (g);
+            separator.push (voiced ? scratch.magnitudes.data() : nullptr, scratch.re.data(), scratch.im.data());
+            pendingVoiced[(size_t) (g % (latency + 1))] = voiced ? 1 : 0;
+
+            int f = g - latency;
+            if (f < firstFrame || ! pendingVoiced[(size_t) (f % (latency + 1))])
+                continue;
+
+            separator.getHarmonic (scratch.magnitudes.data(), scratch.re.data(), scratch.im.data());
+            frameVoiced[(size_t) f] = chromaFromSpectrum (scratch, frameChromas.data() + (size_t) f * 12,
+                                                          frameBassChromas.data() + (size_t) f * 12) ? 1 : 0;
+        }
+    });
+
+    if (threadShouldExit()) return;
+
+    // Deterministic reduction (fixed frame order)
+    double bassChroma[12] = {};
+    for (int f = 0; f < numChromaFrames; ++f)
+    {
+        if (! frameVoiced[(size_t) f]) continue;
+        const double* frameChroma = frameChromas.data() + (size_t) f * 12;
+        const double* frameBass = frameBassChromas.data() + (size_t) f * 12;
+        for (int i = 0; i < 12; ++i)
+        {
+            chroma[i] += frameChroma[i];
+            bassChroma[i] += frameBass[i];
+        }
+    }
+
+    // Keep the voiced frames as a compact 8-bit chromagram
+    {
+        Chromagram gram;
+        gram.hopSeconds = (double) hopSize / targetSampleRate;
+        for (int f = 0; f < numChromaFrames; ++f)
         {
+            if (! frameVoiced[(size_t) f]) continue;
+            const double* frameChroma = frameChromas.data() + (size_t) f * 12;
+            gram.times.push_back ((float) (excerptOffsetSeconds + f * gram.hopSeconds));
             for (int i = 0; i < 12; ++i)
-                chroma[i] += frameChroma[i] / norm;
+                gram.values.push_back ((uint8_t) juce::jlimit (0L, 255L, std::lround (frameChroma[i] * 255.0)));
+        }
+
+        const juce::ScopedLock sl (resultLock);
+        chromagram = std::move (gram);
+    }
+
+    if (trackKeyChanges)
+    {
+        auto segments = trackKeySegments (frameChromas.data(), frameVoiced.data(), numChromaFrames,
+                                          (double) hopSize / targetSampleRate,
+                                          (double) analysisSampleCount / targetSampleRate);
+
+        for (auto& seg : segments)
+        {
+            seg.startSeconds += excerptOffsetSeconds;
+            seg.endSeconds   += excerptOffsetSeconds;
+        }
+
+        for (const auto& seg : segments)
+            DBG ("AudioAnalyzer: Key segment " + juce::String (seg.startSeconds, 1) + "-"
+                 + juce::String (seg.endSeconds, 1) + " s: " + seg.name);
+
+        const juce::ScopedLock sl (resultLock);
+        keySegments = std::move (segments);
+    }
+
+    if (detectChords)
+    {
+        auto chords = trackChords (frameChromas.data(), frameVoiced.data(), numChromaFrames,
+                                   (double) hopSize / targetSampleRate);
+
+        for (auto& chord : chords)
+        {
+            chord.startSeconds += excerptOffsetSeconds;
+            chord.endSeconds   += excerptOffsetSeconds;
         }
+
+        DBG ("AudioAnalyzer: Chord track has " + juce::String ((int) chords.size()) + " events");
+
+        const juce::ScopedLock sl (resultLock);
+        chordTimeline = std::move (chords);
     }
 
     // ── 6. Krumhansl-Schmuckler key profile matching ────────────────────
-    // Correlate chromagram against all 24 key profiles (12 major + 12 minor)
-    const char* noteNames[12] = {"C","C#","D","D#","E","F","F#","G","G#","A","A#","B"};
+    // Correlate chromagram against all 24 keys (12 major + 12 minor) under keyProfileSet
+    const auto& noteNames = NOTE_NAMES;
+
+    // Bass tonic weighting: relative keys share all seven pitch classes, but
+    // the tonic usually dominates the bass line. Each key's score gets a bonus
+    // proportional to how far its root's bass share exceeds the average.
+    double tonicBonus[12];
+    keyprofiles::bassTonicBonus (bassChroma, (double) bassTonicWeight, tonicBonus);
 
     double bestCorr = -2.0;
+    double bestScore = -1.0e30;
     int bestRoot = 0;
     bool bestIsMajor = true;
 
+    double keyCorr[keyprofiles::numKeys];
+    correlateKeys (keyProfileSet, chroma, 1, keyCorr);
+
     DBG ("AudioAnalyzer: Key correlations:");
     for (int root = 0; root < 12; ++root)
     {
-        // Rotate profile: for key with this root, profile[i] maps to chroma[(i + root) % 12]
-        double rotatedMajor[12], rotatedMinor[12];
-        for (int i = 0; i < 12; ++i)
-        {
-            rotatedMajor[(i + root) % 12] = KEY_PROFILE_MAJOR[i];
-            rotatedMinor[(i + root) % 12] = KEY_PROFILE_MINOR[i];
-        }
-
-        double corrMaj = pearsonCorrelation (chroma, rotatedMajor, 12);
-        double corrMin = pearsonCorrelation (chroma, rotatedMinor, 12);
+        double corrMaj = keyCorr[root];
+        double corrMin = keyCorr[12 + root];
 
         DBG ("  " + juce::String (noteNames[root]) + " Major: " + juce::String (corrMaj, 3)
              + "  |  " + juce::String (noteNames[root]) + " Minor: " + juce::String (corrMin, 3));
 
-        if (corrMaj > bestCorr) { bestCorr = corrMaj; bestRoot = root; bestIsMajor = true; }
-        if (corrMin > bestCorr) { bestCorr = corrMin; bestRoot = root; bestIsMajor = false; }
+        double scoreMaj = corrMaj + tonicBonus[root];
+        double scoreMin = corrMin + tonicBonus[root];
+        if (scoreMaj > bestScore) { bestScore = scoreMaj; bestCorr = corrMaj; bestRoot = root; bestIsMajor = true; }
+        if (scoreMin > bestScore) { bestScore = scoreMin; bestCorr = corrMin; bestRoot = root; bestIsMajor = false; }
     }
 
     std::set<int> result;
     juce::String keyName;
     if (bestCorr >= (double) minCorrelation)
     {
-        const int* intervals = bestIsMajor ? MAJOR_INTERVALS : MINOR_INTERVALS;
+        const int* intervals = bestIsMajor ? MusicTheory::MAJOR_INTERVALS : MusicTheory::MINOR_INTERVALS;
         for (int i = 0; i < 7; ++i)
             result.insert ((bestRoot + intervals[i]) % 12);
 
@@ -528,6 +1865,30 @@ void AudioAnalyzer::run()
         DBG ("AudioAnalyzer: No confident key detection (best r=" + juce::String (bestCorr, 3) + ")");
     }
 
+    // ── 6b. Modal / extended scale match ────────────────────────────────
+    // Scales on every root compete: the membership masks pick the pitch
+    // collection, the tonic triad and the bass pick its tonic (see
+    // keyprofiles::bestScale). The tonic may differ from the key's, which
+    // for modal material is usually the relative major or minor.
+    DetectedScale scale;
+    if (detectModes && bestCorr >= (double) minCorrelation)
+    {
+        double scaleCorr[keyprofiles::numScaleCandidates];
+        keyprofiles::correlate (keyprofiles::SCALE_TEMPLATES, chroma, 1, scaleCorr);
+
+        const auto match = keyprofiles::bestScale (scaleCorr, chroma, tonicBonus);
+        const auto& def = MusicTheory::SCALES[match.scale];
+        scale.root = match.root;
+        scale.scaleIndex = match.scale;
+        scale.name = juce::String (noteNames[scale.root]) + " " + def.name;
+        scale.correlation = (float) scaleCorr[match.scale * 12 + match.root];
+        for (int i = 0; i < def.numNotes; ++i)
+            scale.pitchClasses.insert ((scale.root + def.intervals[i]) % 12);
+
+        DBG ("AudioAnalyzer: Detected scale = " + scale.name
+             + " (r=" + juce::String (scale.correlation, 3) + ")");
+    }
+
     // ── 7. Compute alternative keys (Circle of Fifths neighbors) ────────
     std::vector<AlternativeKey> alts;
     if (bestCorr >= (double) minCorrelation)
@@ -537,7 +1898,7 @@ void AudioAnalyzer::run()
         int subRoot = (bestRoot + 5) % 12;
         {
             AlternativeKey alt;
-            const int* ints = bestIsMajor ? MAJOR_INTERVALS : MINOR_INTERVALS;
+            const int* ints = bestIsMajor ? MusicTheory::MAJOR_INTERVALS : MusicTheory::MINOR_INTERVALS;
             for (int i = 0; i < 7; ++i)
                 alt.pitchClasses.insert ((subRoot + ints[i]) % 12);
             alt.name = juce::String (noteNames[subRoot]) + (bestIsMajor ? " Major" : " Minor");
@@ -549,7 +1910,7 @@ void AudioAnalyzer::run()
         int domRoot = (bestRoot + 7) % 12;
         {
             AlternativeKey alt;
-            const int* ints = bestIsMajor ? MAJOR_INTERVALS : MINOR_INTERVALS;
+            const int* ints = bestIsMajor ? MusicTheory::MAJOR_INTERVALS : MusicTheory::MINOR_INTERVALS;
             for (int i = 0; i < 7; ++i)
                 alt.pitchClasses.insert ((domRoot + ints[i]) % 12);
             alt.name = juce::String (noteNames[domRoot]) + (bestIsMajor ? " Major" : " Minor");
@@ -565,6 +1926,8 @@ void AudioAnalyzer::run()
         const juce::ScopedLock sl (resultLock);
         detectedPitchClasses = result;
         detectedKeyName = keyName;
+        detectedScale = scale;
+        std::copy (chroma, chroma + 12, keyChroma.begin());
         alternativeKeys = alts;
     }
 
@@ -572,8 +1935,9 @@ void AudioAnalyzer::run()
          + fileToAnalyze.getFileName());
 
     // ── 8.5. BPM detection: multi-band spectral flux ODF + fractional-lag AC ─
-    // Based on Scheirer (1998): run the same analysis on three frequency bands
-    // (full spectrum, bass 50-300 Hz, mid 300-2000 Hz) and vote across bands.
+    // Based on Scheirer (1998): run the same analysis on the full spectrum and
+    // on each bpmBandEdgesHz sub-band (default bass 50-300 Hz, mid 300-2000 Hz)
+    // and vote across bands.
     //
     // Per-band algorithm:
     //  1. Spectral flux ODF (log-compressed magnitude diff, per-band FFT bins)
@@ -583,10 +1947,12 @@ void AudioAnalyzer::run()
     //  4. Extended BPM range 50-220; improved octave correction (checks ×0.5,
     //     ×2 candidates and prefers 70-155 BPM natural range)
     //
-    // Confidence: 1.0 = all 3 bands agree; 0.65 = 2 agree; 0.4 = bass only;
-    //             0.0 = no result
+    // Confidence: 1.0 = all bands agree; 0.65-0.95 = a subset agrees; below
+    //             0.45 = bass (or full) band alone; 0.0 = no result
     float bpm = 0.0f;
     float bpmConfidence = 0.0f;
+    double centroidSum = 0.0;      // Per-frame magnitude-weighted mean bin
+    int centroidFrames = 0;
     {
         const int bpmFftSize = 2048;
         const int bpmHop     = 512;
@@ -608,21 +1974,42 @@ void AudioAnalyzer::run()
             std::vector<float> bpmIm      ((size_t) bpmComplexSize);
             std::vector<float> prevLogMag ((size_t) bpmComplexSize, 0.0f);
             std::vector<float> currLogMag ((size_t) bpmComplexSize);
-
-            // Frequency band boundaries (FFT bin indices)
-            // Bass: 50-300 Hz — contains kick drum / bass guitar (best BPM indicator)
-            // Mid:  300-2000 Hz — contains snare, hi-hat
-            int bassLow  = std::max (1,    (int) std::ceil  (50.0   * bpmFftSize / targetSampleRate));
-            int bassHigh = std::min ((int) bpmComplexSize - 1,
-                                     (int) std::floor (300.0  * bpmFftSize / targetSampleRate));
-            int midLow   =           (int) std::ceil  (300.0  * bpmFftSize / targetSampleRate);
-            int midHigh  = std::min ((int) bpmComplexSize - 1,
-                                     (int) std::floor (2000.0 * bpmFftSize / targetSampleRate));
+            std::vector<float> bpmMag     ((size_t) bpmComplexSize);
+            const auto bpmKernels = framekernels::forSize (bpmFftSize);
+
+            // Sub-band boundaries (FFT bin indices), ascending. With the
+            // default edges: bass 50-300 Hz (kick drum / bass guitar, the best
+            // BPM indicator) and mid 300-2000 Hz (snare, hi-hat)
+            struct FluxBand { int low, high; };
+            std::vector<FluxBand> subBands;
+            for (size_t e = 0; e + 1 < bpmBandEdgesHz.size(); ++e)
+            {
+                int low  = std::max (1, (int) std::ceil (bpmBandEdgesHz[e] * bpmFftSize / targetSampleRate));
+                int high = std::min ((int) bpmComplexSize - 1,
+                                     (int) std::floor (bpmBandEdgesHz[e + 1] * bpmFftSize / targetSampleRate));
+                if (high >= low)
+                    subBands.push_back ({ low, high });
+            }
 
             // ── Stage 1: spectral flux per band (single FFT pass) ─────────────
-            std::vector<float> onsetFull ((size_t) numFrames, 0.0f);
-            std::vector<float> onsetBass ((size_t) numFrames, 0.0f);
-            std::vector<float> onsetMid  ((size_t) numFrames, 0.0f);
+            // One prefix sum of the positive log-magnitude differences per
+            // frame; each band's flux is then a single subtraction, so the
+            // band count costs O(bands) per frame rather than O(bins × bands).
+            // Band 0 is the full spectrum, band 1 + k sub-band k.
+            //
+            // Envelopes live in onsetArena, four rows per band: raw flux,
+            // detrended envelope, the detrending prefix sum and the decimated
+            // envelope. Bands only ever touch their own rows.
+            const int numOnsetBands = 1 + (int) subBands.size();
+            onsetArena.prepare (4 * numOnsetBands, numFrames + 1);
+            while ((int) bandAutocorrelators.size() < numOnsetBands)
+                bandAutocorrelators.push_back (std::make_unique<Autocorrelator>());
+            auto onsetRow  = [this]                (int band) { return onsetArena.row (band); };
+            auto envRow    = [this, numOnsetBands] (int band) { return onsetArena.row (numOnsetBands + band); };
+            auto prefixRow = [this, numOnsetBands] (int band) { return onsetArena.row (2 * numOnsetBands + band); };
+            auto coarseRow = [this, numOnsetBands] (int band) { return onsetArena.row (3 * numOnsetBands + band); };
+
+            std::vector<float> fluxPrefix (bpmComplexSize + 1, 0.0f);
             const float kLog = 1000.0f;
 
             for (int f = 0; f < numFrames && !threadShouldExit(); ++f)
@@ -630,157 +2017,264 @@ void AudioAnalyzer::run()
                 int offset    = f * bpmHop;
                 int available = std::min (bpmFftSize, analysisSampleCount - offset);
 
-                for (int i = 0; i < available; ++i)
-                    bpmBuf[(size_t) i] = analysisSamples[offset + i] * bpmWin[(size_t) i];
-                for (int i = available; i < bpmFftSize; ++i)
-                    bpmBuf[(size_t) i] = 0.0f;
+                if (available == bpmFftSize)
+                {
+                    bpmKernels.applyWindow (analysisSamples + offset, bpmWin.data(), bpmBuf.data(), bpmFftSize);
+                }
+                else
+                {
+                    for (int i = 0; i < available; ++i)
+                        bpmBuf[(size_t) i] = analysisSamples[offset + i] * bpmWin[(size_t) i];
+                    for (int i = available; i < bpmFftSize; ++i)
+                        bpmBuf[(size_t) i] = 0.0f;
+                }
 
                 bpmFft.fft (bpmBuf.data(), bpmRe.data(), bpmIm.data());
+                bpmKernels.magnitudes (bpmRe.data(), bpmIm.data(), bpmMag.data(), (int) bpmComplexSize);
 
-                float fluxFull = 0.0f, fluxBass = 0.0f, fluxMid = 0.0f;
+                float magSum = 0.0f, weightedBinSum = 0.0f;
                 for (int b = 0; b < (int) bpmComplexSize; ++b)
                 {
-                    float mag    = std::sqrt (bpmRe[(size_t) b] * bpmRe[(size_t) b]
-                                           + bpmIm[(size_t) b] * bpmIm[(size_t) b]);
-                    float logMag = std::log (1.0f + kLog * mag);
+                    float mag    = bpmMag[(size_t) b];
+                    magSum         += mag;
+                    weightedBinSum += mag * (float) b;
+                    float logMag = fastmath::log1p (kLog * mag);
                     currLogMag[(size_t) b] = logMag;
                     float diff = logMag - prevLogMag[(size_t) b];
-                    if (diff > 0.0f)
-                    {
-                        fluxFull += diff;
-                        if (b >= bassLow && b <= bassHigh) fluxBass += diff;
-                        if (b >= midLow  && b <= midHigh)  fluxMid  += diff;
-                    }
+                    fluxPrefix[(size_t) b + 1] = fluxPrefix[(size_t) b] + std::max (0.0f, diff);
                 }
-                onsetFull[(size_t) f] = fluxFull;
-                onsetBass[(size_t) f] = fluxBass;
-                onsetMid [(size_t) f] = fluxMid;
+                onsetRow (0)[f] = fluxPrefix[bpmComplexSize];
+                for (size_t k = 0; k < subBands.size(); ++k)
+                    onsetRow ((int) k + 1)[f] = fluxPrefix[(size_t) subBands[k].high + 1]
+                                              - fluxPrefix[(size_t) subBands[k].low];
                 std::swap (currLogMag, prevLogMag);
+
+                // Skip near-silent frames so fades do not drag the centroid down
+                if (magSum > 1.0e-3f * (float) bpmFftSize)
+                {
+                    centroidSum += weightedBinSum / magSum * targetSampleRate / bpmFftSize;
+                    ++centroidFrames;
+                }
             }
 
-            if (!threadShouldExit())
+            // Stage 1 also feeds the spectral centroid, so only the tempo
+            // stages are skipped when the caller does not want the tempo
+            if (detectTempo && !threadShouldExit())
             {
                 double sr = targetSampleRate;
-                // lagMaxF: lag in frames for 50 BPM (extended lower bound)
-                float lagMaxF = (float) (60.0 * sr / ((double) bpmHop * 50.0));
+                // lagMaxF: lag in frames for the slowest tempo searched
+                float lagMaxF = (float) (60.0 * sr / ((double) bpmHop * minBPM));
+                const double framesPerMinute = 60.0 * sr / (double) bpmHop;
+
+                // Per-band result: finalBPM, peak sharpness 0-1, and the band's
+                // detrended envelope (an onsetArena row) and autocorrelation for
+                // later stages; ac stays empty when the search was decimated
+                struct BandTempo
+                {
+                    float bpm = 0.0f, sharpness = 0.0f;
+                    const float* env = nullptr;
+                    std::vector<float> ac;
+                };
 
-                // ── Stage 2+3+4 encapsulated as a lambda (reused per band) ──
-                // Takes onset envelope by value (modified in-place by Stage 2).
-                // Returns {finalBPM, peakSharpness 0-1}.
-                auto computeBPMFromEnv = [&] (std::vector<float> env) -> std::pair<float, float>
+                // Best score over the bpmStep grid within [lo, hi], and the
+                // rival: the best score outside ±5% of the winner and of its
+                // double and half time. Neighbouring grid points sit on the
+                // winner's own peak and octaves are the octave check's
+                // business, so neither counts against the peak's sharpness.
+                const float step = juce::jmax (0.01f, bpmStep);
+                auto searchTempo = [&] (const TempoScorer& scorer, float lo, float hi,
+                                        float& bestBPM, float& bestScore, float& rivalScore)
                 {
-                    int n = (int) env.size();
+                    int first = juce::jmax (0, (int) std::ceil ((lo - minBPM) / step - 1.0e-4f));
+                    int last  = juce::jmin ((int) std::floor ((maxBPM - minBPM) / step),
+                                            (int) std::floor ((hi - minBPM) / step + 1.0e-4f));
+                    std::vector<float> gridScores ((size_t) juce::jmax (0, last - first + 1), 0.0f);
+                    for (int ci = first; ci <= last && !threadShouldExit(); ++ci)
+                    {
+                        float cBPM  = minBPM + (float) ci * step;
+                        float score = scorer.score (cBPM);
+                        gridScores[(size_t) (ci - first)] = score;
+                        if (score > bestScore)
+                        {
+                            bestScore = score;
+                            bestBPM   = cBPM;
+                        }
+                    }
+
+                    for (int ci = first; ci <= last; ++ci)
+                    {
+                        float cBPM = minBPM + (float) ci * step;
+                        bool related = false;
+                        for (float octave : { 1.0f, 2.0f, 0.5f })
+                            related = related || std::abs (cBPM - octave * bestBPM) <= 0.05f * octave * bestBPM;
+                        if (! related)
+                            rivalScore = juce::jmax (rivalScore, gridScores[(size_t) (ci - first)]);
+                    }
+                };
+
+                // ── Stage 2+3+4 encapsulated as a lambda (reused per band) ──
+                // Reads the band's raw onset row; everything it writes is
+                // band-local, so bands can run concurrently.
+                const int decimation = juce::jmax (1, bpmDecimation);
 
-                    // Stage 2: moving-average subtraction (prefix-sum O(n))
+                // Stage 2: moving-average subtraction (prefix-sum O(n)) into the
+                // band's envelope row
+                auto detrendBand = [&] (int band)
+                {
+                    const float* onset = onsetRow (band);
+                    float* env = envRow (band);
+                    const int n = numFrames;
                     int halfWin = std::max (1, (int) (targetSampleRate / bpmHop) / 2);
-                    std::vector<float> prefix ((size_t) (n + 1), 0.0f);
+                    float* prefix = prefixRow (band);
+                    prefix[0] = 0.0f;
                     for (int f2 = 0; f2 < n; ++f2)
-                        prefix[(size_t) (f2 + 1)] = prefix[(size_t) f2] + env[(size_t) f2];
+                        prefix[f2 + 1] = prefix[f2] + onset[f2];
                     for (int f2 = 0; f2 < n; ++f2)
                     {
                         int lo = std::max (0, f2 - halfWin);
                         int hi = std::min (n - 1, f2 + halfWin);
-                        float mn = (prefix[(size_t) (hi + 1)] - prefix[(size_t) lo])
-                                   / (float) (hi - lo + 1);
-                        env[(size_t) f2] = std::max (0.0f, env[(size_t) f2] - mn);
+                        float mn = (prefix[hi + 1] - prefix[lo]) / (float) (hi - lo + 1);
+                        env[f2] = std::max (0.0f, onset[f2] - mn);
                     }
+                    return env;
+                };
 
-                    // Stage 3: fractional-lag AC with 4-harmonic weighting
-                    // Interpolates envelope at fractional lag → eliminates quantisation error.
-                    auto computeACfrac = [&] (float lagF) -> float
-                    {
-                        if (lagF < 1.0f || lagF >= (float) (n - 1)) return 0.0f;
-                        int   lagI  = (int) lagF;
-                        float frac  = lagF - (float) lagI;
-                        int   count = n - lagI - 1;
-                        if (count <= 0) return 0.0f;
-                        float ac = 0.0f;
-                        for (int i = 0; i < count; ++i)
-                        {
-                            float shifted = env[(size_t) (i + lagI)]     * (1.0f - frac)
-                                          + env[(size_t) (i + lagI + 1)] * frac;
-                            ac += env[(size_t) i] * shifted;
-                        }
-                        return ac / (float) count;
-                    };
-
-                    // Compute 4-harmonic score for any BPM
-                    auto scoreForBPM = [&] (float b) -> float
-                    {
-                        if (b < 50.0f || b > 220.0f) return 0.0f;
-                        float lagF = (float) (60.0 * sr / ((double) bpmHop * (double) b));
-                        float s = computeACfrac (lagF);
-                        if (lagF * 2.0f <= lagMaxF) s += 0.5f   * computeACfrac (lagF * 2.0f);
-                        if (lagF * 3.0f <= lagMaxF) s += 0.25f  * computeACfrac (lagF * 3.0f);
-                        if (lagF * 4.0f <= lagMaxF) s += 0.125f * computeACfrac (lagF * 4.0f);
-                        return s;
-                    };
+                auto computeBPMFromEnv = [&] (int band, BandTempo& out)
+                {
+                    float* env = detrendBand (band);
+                    const int n = numFrames;
+                    out.env = env;
+                    Autocorrelator& autocorrelator = *bandAutocorrelators[(size_t) band];
 
                     float bestScore  = 0.0f;
-                    float secondBest = 0.0f;
+                    float rivalScore = 0.0f;
                     float bestBPM    = 0.0f;
+                    float finalBPM   = 0.0f;
+                    const int acSize = (int) std::ceil (lagMaxF) + 3;
 
-                    // Extended search range: 50-220 BPM at 0.25 BPM steps
-                    for (float cBPM = 50.0f; cBPM <= 220.0f && !threadShouldExit(); cBPM += 0.25f)
+                    if (decimation > 1 && n / decimation > 32)
                     {
-                        float score = scoreForBPM (cBPM);
-                        if (score > bestScore)
+                        // Coarse pass: the same search on the envelope averaged
+                        // over decimation frames, so the FFT autocorrelation
+                        // touches n / decimation values
+                        const int nc = n / decimation;
+                        float* coarse = coarseRow (band);
+                        for (int i = 0; i < nc; ++i)
                         {
-                            secondBest = bestScore;
-                            bestScore  = score;
-                            bestBPM    = cBPM;
+                            float sum = 0.0f;
+                            for (int k = 0; k < decimation; ++k)
+                                sum += env[i * decimation + k];
+                            coarse[i] = sum / (float) decimation;
                         }
-                        else if (score > secondBest)
+                        const float coarseLagMaxF = lagMaxF / (float) decimation;
+                        autocorrelator.prepare (nc, (int) std::ceil (coarseLagMaxF) + 2);
+                        const auto& coarseAC = autocorrelator.process (coarse, nc);
+                        const TempoScorer coarseScorer { coarse, nc, &coarseAC, framesPerMinute / decimation,
+                                                         coarseLagMaxF, minBPM, maxBPM };
+                        float coarseBPM = 0.0f;
+                        searchTempo (coarseScorer, minBPM, maxBPM, coarseBPM, bestScore, rivalScore);
+                        if (coarseBPM == 0.0f || bestScore == 0.0f) return;
+
+                        // Refinement at full resolution within one coarse frame
+                        // of lag either side. Only the AC lags that window and
+                        // the octave check read are computed, as direct sums.
+                        const float coarseLag = (float) (framesPerMinute / coarseBPM);
+                        const float lo = (float) (framesPerMinute / (coarseLag + (float) decimation));
+                        const float hi = coarseLag > (float) decimation ? (float) (framesPerMinute / (coarseLag - (float) decimation))
+                                                                        : maxBPM;
+                        std::vector<float> sparseAC ((size_t) acSize, 0.0f);
+                        std::vector<uint8_t> needed ((size_t) acSize, 0);
+                        for (float octave : { 1.0f, 2.0f, 0.5f })
+                            for (int h = 1; h <= 4; ++h)
+                            {
+                                int lagLo = (int) std::floor (h * framesPerMinute / (hi * octave));
+                                int lagHi = (int) std::floor (h * framesPerMinute / (lo * octave)) + 1;
+                                for (int lag = juce::jmax (1, lagLo); lag <= juce::jmin (acSize - 1, lagHi); ++lag)
+                                    needed[(size_t) lag] = 1;
+                            }
+                        for (int lag = 1; lag < acSize && lag < n; ++lag)
                         {
-                            secondBest = score;
+                            if (! needed[(size_t) lag]) continue;
+                            float sum = 0.0f;
+                            for (int i = 0; i + lag < n; ++i)
+                                sum += env[i] * env[i + lag];
+                            sparseAC[(size_t) lag] = sum;
                         }
-                    }
-
-                    if (bestBPM == 0.0f || bestScore == 0.0f) return { 0.0f, 0.0f };
-
-                    // Peak sharpness: how much best score exceeds second-best (0-1)
-                    float sharpness = (secondBest > 0.0f)
-                        ? juce::jmin (1.0f, (bestScore - secondBest) / bestScore)
-                        : 1.0f;
 
-                    // Stage 4: improved octave correction
-                    // Check ×2 and ×0.5 candidates; prefer whichever falls in
-                    // the 70-155 BPM "natural" range without sacrificing accuracy.
-                    float candidateBPMs[3] = { bestBPM, bestBPM * 2.0f, bestBPM * 0.5f };
-                    float naturalBPM   = 0.0f;
-                    float naturalScore = 0.0f;
+                        // Sharpness stays the coarse search's: it saw every candidate
+                        const TempoScorer scorer { env, n, &sparseAC, framesPerMinute, lagMaxF, minBPM, maxBPM };
+                        float fineScore = 0.0f, fineRival = 0.0f;
+                        searchTempo (scorer, lo, hi, bestBPM, fineScore, fineRival);
+                        if (bestBPM == 0.0f || fineScore == 0.0f) return;
 
-                    for (int ci = 0; ci < 3; ++ci)
+                        // Stage 4: improved octave correction
+                        finalBPM = scorer.naturalOctave (bestBPM, fineScore);
+                    }
+                    else
                     {
-                        float cb = candidateBPMs[ci];
-                        if (cb >= 70.0f && cb <= 155.0f)
-                        {
-                            float cs = scoreForBPM (cb);
-                            if (cs > naturalScore) { naturalScore = cs; naturalBPM = cb; }
-                        }
+                        // Stage 3: fractional-lag AC with 4-harmonic weighting, from
+                        // the integer-lag AC computed with one FFT per band
+                        autocorrelator.prepare (n, acSize - 1);
+                        out.ac = autocorrelator.process (env, n);
+                        const TempoScorer scorer { env, n, &out.ac, framesPerMinute, lagMaxF, minBPM, maxBPM };
+
+                        // Search minBPM-maxBPM at bpmStep spacing
+                        searchTempo (scorer, minBPM, maxBPM, bestBPM, bestScore, rivalScore);
+                        if (bestBPM == 0.0f || bestScore == 0.0f) return;
+
+                        // Stage 4: improved octave correction
+                        finalBPM = scorer.naturalOctave (bestBPM, bestScore);
                     }
 
-                    float finalBPM = bestBPM;
-                    if (naturalBPM > 0.0f && naturalScore >= 0.45f * bestScore)
-                        finalBPM = naturalBPM;
+                    // Peak sharpness: how far the best score stands above the
+                    // rival peak (0-1)
+                    float sharpness = (rivalScore > 0.0f)
+                        ? juce::jlimit (0.0f, 1.0f, (bestScore - rivalScore) / bestScore)
+                        : 1.0f;
 
-                    if (finalBPM < 50.0f || finalBPM > 220.0f) finalBPM = 0.0f;
+                    if (finalBPM < minBPM || finalBPM > maxBPM) finalBPM = 0.0f;
 
-                    return { finalBPM, sharpness };
+                    out.bpm = finalBPM;
+                    out.sharpness = sharpness;
                 };
 
-                // Run analysis on all 3 bands
-                auto resultFull = computeBPMFromEnv (onsetFull);
-                auto resultBass = computeBPMFromEnv (onsetBass);
-                auto resultMid  = computeBPMFromEnv (onsetMid);
+                // Run the bands concurrently, joining only for the vote. With
+                // early exit on, bass runs first so a sharp enough bass peak
+                // can skip the other searches.
+                std::vector<BandTempo> results ((size_t) numOnsetBands);
+                const int numVoters = (bpmBands > 1) ? numOnsetBands : 1;
+                bool bassAlone = false;
+                if (numVoters > 1)
+                {
+                    int firstBand = 0;
+                    std::vector<int> order { 1, 0 };         // Bass first, then full, then upward
+                    for (int band = 2; band < numOnsetBands; ++band)
+                        order.push_back (band);
+
+                    if (bpmEarlyExitSharpness <= 1.0f)
+                    {
+                        computeBPMFromEnv (1, results[1]);
+                        bassAlone = results[1].bpm > 0.0f && results[1].sharpness >= bpmEarlyExitSharpness;
+                        firstBand = bassAlone ? numVoters : 1;
+                    }
 
-                float bpmFull  = resultFull.first,  confFull  = resultFull.second;
-                float bpmBass  = resultBass.first,  confBass  = resultBass.second;
-                float bpmMid   = resultMid.first,   confMid   = resultMid.second;
+                    parallelFor (numVoters - firstBand, [&] (int t)
+                    {
+                        int band = order[(size_t) (firstBand + t)];
+                        computeBPMFromEnv (band, results[(size_t) band]);
+                    });
+                }
+                else
+                {
+                    computeBPMFromEnv (0, results[0]);
+                }
 
-                DBG ("AudioAnalyzer: BPM estimates — Full:" + juce::String (bpmFull, 1)
-                     + " Bass:" + juce::String (bpmBass, 1)
-                     + " Mid:"  + juce::String (bpmMid,  1));
+                juce::String estimates;
+                for (int band = 0; band < numOnsetBands; ++band)
+                    estimates += (band == 0 ? " Full:" : band == 1 ? " Bass:" : " Band" + juce::String (band) + ":")
+                                 + juce::String (results[(size_t) band].bpm, 1)
+                                 + " (" + juce::String (results[(size_t) band].sharpness, 2) + ")";
+                DBG ("AudioAnalyzer: BPM estimates —" + estimates);
 
                 // ── Multi-band voting (agree = within 3%) ──────────────────
                 auto bpmMatch = [] (float a, float b2) -> bool
@@ -789,50 +2283,224 @@ void AudioAnalyzer::run()
                     return std::abs (a - b2) / ((a + b2) * 0.5f) < 0.03f;
                 };
 
-                bool fullBassAgree = bpmMatch (bpmFull, bpmBass);
-                bool fullMidAgree  = bpmMatch (bpmFull, bpmMid);
-                bool bassMidAgree  = bpmMatch (bpmBass, bpmMid);
-                int  agreements    = (fullBassAgree ? 1 : 0) + (fullMidAgree ? 1 : 0) + (bassMidAgree ? 1 : 0);
-
-                if (agreements == 3)
+                // Largest set of mutually agreeing bands, grown greedily from
+                // each seed in priority order (full, bass, then upward); the
+                // first seed wins ties. With the default three bands this is
+                // all three, else full+bass, full+mid, then bass+mid.
+                std::vector<int> agreeing;
+                for (int seed = 0; seed < numVoters; ++seed)
                 {
-                    // All agree — weighted average by sharpness
-                    float totalConf = confFull + confBass + confMid;
-                    bpm = totalConf > 0.0f
-                        ? (bpmFull * confFull + bpmBass * confBass + bpmMid * confMid) / totalConf
-                        : (bpmFull + bpmBass + bpmMid) / 3.0f;
-                    bpmConfidence = 1.0f;
+                    if (results[(size_t) seed].bpm <= 0.0f)
+                        continue;
+                    std::vector<int> group { seed };
+                    for (int band = 0; band < numVoters; ++band)
+                    {
+                        if (band == seed) continue;
+                        bool agreesWithAll = true;
+                        for (int member : group)
+                            agreesWithAll = agreesWithAll && bpmMatch (results[(size_t) band].bpm, results[(size_t) member].bpm);
+                        if (agreesWithAll)
+                            group.push_back (band);
+                    }
+                    if (group.size() > agreeing.size())
+                        agreeing = std::move (group);
                 }
-                else if (fullBassAgree)
+
+                if (bassAlone)
                 {
-                    bpm = (bpmFull + bpmBass) * 0.5f;
-                    bpmConfidence = 0.70f;
+                    // Early exit: the bass peak was sharp enough to stand for
+                    // the vote, so its sharpness is the confidence
+                    bpm = results[1].bpm;
+                    bpmConfidence = results[1].sharpness;
                 }
-                else if (fullMidAgree)
+                else if (agreeing.size() >= 2 && (int) agreeing.size() == numVoters)
                 {
-                    bpm = (bpmFull + bpmMid) * 0.5f;
-                    bpmConfidence = 0.65f;
+                    // All agree — weighted average by sharpness
+                    float totalConf = 0.0f, weighted = 0.0f, plain = 0.0f;
+                    for (int band : agreeing)
+                    {
+                        totalConf += results[(size_t) band].sharpness;
+                        weighted  += results[(size_t) band].bpm * results[(size_t) band].sharpness;
+                        plain     += results[(size_t) band].bpm;
+                    }
+                    bpm = totalConf > 0.0f ? weighted / totalConf : plain / (float) numVoters;
+                    bpmConfidence = 1.0f;
                 }
-                else if (bassMidAgree)
+                else if (agreeing.size() >= 2)
                 {
-                    bpm = (bpmBass + bpmMid) * 0.5f;
-                    bpmConfidence = 0.65f;
+                    // A subset agrees — 0.65 for a pair, rising with the share
+                    // of bands in the group; full + bass together earn +0.05
+                    float sum = 0.0f;
+                    bool hasFull = false, hasBass = false;
+                    for (int band : agreeing)
+                    {
+                        sum += results[(size_t) band].bpm;
+                        hasFull = hasFull || band == 0;
+                        hasBass = hasBass || band == 1;
+                    }
+                    bpm = sum / (float) agreeing.size();
+                    bpmConfidence = 0.65f + 0.3f * (float) (agreeing.size() - 2) / (float) juce::jmax (1, numVoters - 2)
+                                  + (hasFull && hasBass ? 0.05f : 0.0f);
                 }
-                else if (bpmBass > 0.0f)
+                else if (numVoters > 1 && results[1].bpm > 0.0f)
                 {
                     // Bass band most reliable when bands disagree
-                    bpm = bpmBass;
-                    bpmConfidence = confBass * 0.45f;
+                    bpm = results[1].bpm;
+                    bpmConfidence = results[1].sharpness * 0.45f;
                 }
-                else if (bpmFull > 0.0f)
+                else if (results[0].bpm > 0.0f)
                 {
-                    bpm = bpmFull;
-                    bpmConfidence = confFull * 0.40f;
+                    bpm = results[0].bpm;
+                    bpmConfidence = results[0].sharpness * 0.40f;
+                }
+
+                // Detrended full-band and bass envelopes for the later stages,
+                // whichever band won the vote; a band the early exit skipped
+                // is detrended here. fullAC is empty in that case.
+                const float* fullEnv = results[0].env != nullptr ? results[0].env : detrendBand (0);
+                const float* bassEnv = numOnsetBands == 1 ? fullEnv
+                                     : results[1].env != nullptr ? results[1].env : detrendBand (1);
+                const std::vector<float>& fullAC = results[0].ac;
+
+                // ── Tempogram: windowed autocorrelation over time ───────────
+                // One FFT plan serves every window; each window is scored with
+                // the same harmonic AC measure as the global search. Each
+                // window is transformed from scratch rather than slid. The
+                // windows are also computed for tempogramMode alone, but only
+                // published with computeTempogram.
+                if ((computeTempogram || tempogramMode) && !threadShouldExit())
+                {
+                    const float* env = fullEnv;
+                    const int n = numFrames;
+                    const double framesPerSecond = sr / bpmHop;
+                    const int windowFrames = juce::jmax (16, (int) std::round (tempogramWindowSeconds * framesPerSecond));
+                    const int hopFrames = juce::jmax (1, (int) std::round (tempogramHopSeconds * framesPerSecond));
+                    const float windowLagMaxF = juce::jmin (lagMaxF, (float) (windowFrames - 2));
+
+                    auto& autocorrelator = tempogramAutocorrelator;
+                    autocorrelator.prepare (windowFrames, (int) std::ceil (windowLagMaxF) + 2);
+
+                    std::vector<TempoPoint> points;
+                    const int numCandidates = (int) std::floor ((maxBPM - minBPM) / step) + 1;
+                    for (int start = 0; start + windowFrames <= n && !threadShouldExit(); start += hopFrames)
+                    {
+                        const auto& windowAC = autocorrelator.process (env + start, windowFrames);
+                        const TempoScorer scorer { env + start, windowFrames, &windowAC,
+                                                   framesPerMinute, windowLagMaxF, minBPM, maxBPM };
+
+                        float bestScore = 0.0f, bestBPM = 0.0f;
+                        for (int ci = 0; ci < numCandidates; ++ci)
+                        {
+                            float cBPM = minBPM + (float) ci * step;
+                            float score = scorer.score (cBPM);
+                            if (score > bestScore) { bestScore = score; bestBPM = cBPM; }
+                        }
+                        if (bestBPM <= 0.0f || windowAC[0] <= 0.0f)
+                            continue;
+
+                        TempoPoint point;
+                        point.timeSeconds = excerptOffsetSeconds + (start + 0.5 * windowFrames) / framesPerSecond
+                                          + 0.5 * bpmFftSize / sr;
+                        point.bpm = scorer.naturalOctave (bestBPM, bestScore);
+                        // Confidence: autocorrelation coefficient at the beat lag
+                        float lagF = (float) (framesPerMinute / point.bpm);
+                        point.confidence = juce::jlimit (0.0f, 1.0f, scorer.acFrac (lagF) / (windowAC[0] / (float) windowFrames));
+                        points.push_back (point);
+                    }
+
+                    // Global tempo = confidence-weighted mode over 1 BPM bins,
+                    // refined to the weighted mean of the points in that bin
+                    if (tempogramMode && ! points.empty())
+                    {
+                        const int firstBin = (int) std::floor (minBPM);
+                        std::vector<double> weight ((size_t) ((int) std::ceil (maxBPM) - firstBin + 1), 0.0);
+                        double totalWeight = 0.0;
+                        for (const auto& p : points)
+                        {
+                            weight[(size_t) juce::jlimit (0, (int) weight.size() - 1, (int) std::round (p.bpm) - firstBin)] += p.confidence;
+                            totalWeight += p.confidence;
+                        }
+
+                        int modeBin = (int) (std::max_element (weight.begin(), weight.end()) - weight.begin());
+                        double sum = 0.0, sumWeight = 0.0, agreeWeight = 0.0;
+                        for (const auto& p : points)
+                        {
+                            if ((int) std::round (p.bpm) - firstBin == modeBin) { sum += p.bpm * p.confidence; sumWeight += p.confidence; }
+                            if (std::abs (p.bpm - (float) (modeBin + firstBin)) < 0.03f * (float) (modeBin + firstBin))
+                                agreeWeight += p.confidence;
+                        }
+
+                        if (sumWeight > 0.0)
+                        {
+                            bpm = (float) (sum / sumWeight);
+                            bpmConfidence = (float) (agreeWeight / totalWeight);
+                        }
+                    }
+
+                    DBG ("AudioAnalyzer: Tempogram has " + juce::String ((int) points.size()) + " windows");
+
+                    if (computeTempogram)
+                    {
+                        const juce::ScopedLock sl (resultLock);
+                        tempogram = std::move (points);
+                    }
                 }
 
                 // Round to nearest 0.5 BPM (avoid spurious sub-integer precision)
                 if (bpm > 0.0f)
                     bpm = std::round (bpm * 2.0f) / 2.0f;
+
+                // ── Beat grid: DP beat tracking at the voted tempo ──────────
+                if (trackBeats && bpm > 0.0f && !threadShouldExit())
+                {
+                    const double framesPerSecond = sr / bpmHop;
+                    auto beatFrames = trackBeatFrames (fullEnv, numFrames, framesPerSecond * 60.0 / bpm);
+
+                    BeatGrid grid;
+                    grid.bpm = bpm;
+                    // Flux frame f describes the window centred on f·hop + fftSize/2
+                    const double frameCentre = 0.5 * bpmFftSize / sr;
+                    for (int f : beatFrames)
+                        grid.beatTimes.push_back (excerptOffsetSeconds + f / framesPerSecond + frameCentre);
+
+                    if (! grid.beatTimes.empty())
+                    {
+                        grid.phaseSeconds = std::fmod (grid.beatTimes.front(), 60.0 / bpm);
+
+                        if (detectMeter)
+                        {
+                            estimateMeter (fullEnv, bassEnv, numFrames, fullAC, *bandAutocorrelators[0], beatFrames,
+                                           framesPerSecond * 60.0 / bpm, grid);
+                        }
+                        else
+                        {
+                            // Assume 4 beats per bar: the downbeat is the bar
+                            // position whose beats carry the most bass onset energy
+                            double slotEnergy[4] = {};
+                            for (size_t b = 0; b < beatFrames.size(); ++b)
+                                slotEnergy[b % 4] += bassEnv[beatFrames[b]];
+                            grid.firstDownbeat = (int) (std::max_element (slotEnergy, slotEnergy + 4) - slotEnergy);
+                        }
+
+                        if (grid.firstDownbeat >= 0 && grid.firstDownbeat < (int) grid.beatTimes.size())
+                        {
+                            grid.firstDownbeatSeconds = grid.beatTimes[(size_t) grid.firstDownbeat];
+                            for (size_t b = (size_t) grid.firstDownbeat; b < grid.beatTimes.size(); b += (size_t) grid.beatsPerBar)
+                                grid.downbeatTimes.push_back (grid.beatTimes[b]);
+                        }
+                        else
+                        {
+                            grid.firstDownbeat = -1;
+                        }
+                    }
+
+                    DBG ("AudioAnalyzer: Beat grid has " + juce::String ((int) grid.beatTimes.size())
+                         + " beats, meter " + grid.meter
+                         + ", first downbeat at " + juce::String (grid.firstDownbeatSeconds, 2) + " s");
+
+                    const juce::ScopedLock sl (resultLock);
+                    beatGrid = std::move (grid);
+                }
             }
         }
 
@@ -846,5 +2514,16 @@ void AudioAnalyzer::run()
              + " (confidence " + juce::String (bpmConfidence, 2) + ")");
     }
 
+    if (centroidFrames > 0)
+        levels.spectralCentroidHz = (float) (centroidSum / centroidFrames);
+
+    {
+        const juce::ScopedLock sl (resultLock);
+        descriptors = levels;
+    }
+
+    DBG ("AudioAnalyzer: loudness = " + juce::String (levels.integratedLoudnessLUFS, 1)
+         + " LUFS, true peak = " + juce::String (levels.truePeakDBTP, 1) + " dBTP");
+
     analysisComplete.store (true);
 }
@@ -0,0 +1,103 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// ── Fast approximate math for the analyzer hot loops ─────────────────────
+// Branch-free polynomial approximations that the compiler can vectorise.
+// Build with SCALEFINDER_FAST_MATH=0 to route every call to <cmath>.
+//
+// Accuracy contract (float, measured against double-precision <cmath>):
+//   log2         |error| <= 7e-6   absolute, over all normal inputs
+//   log          |error| <= 9e-6   absolute, over all normal inputs
+//   log1p        |error| <= 4e-6   absolute, for 0 <= x <= 1e9
+//   exp2         relative error <= 2e-7 for results in the normal range
+//   exp          relative error <= 4e-6 for results in the normal range
+//   rsqrt        relative error <= 5e-6 over all normal inputs
+// Most of the absolute log error at large inputs is the float rounding of
+// the result itself; the polynomials alone are good to ~3e-6.
+// log2 / log of zero, negative or denormal input is undefined — callers
+// guard against those. Exact results: log2(2^k) = k for every normal power
+// of two, and log1p(0) = 0. exp2 saturates instead of over/underflowing:
+// inputs below -126 return ~2^-126 (never 0) and inputs above 128 return a
+// finite ~3.4e38 (never inf). Tests/FastMathTests.cpp checks all of this.
+#ifndef SCALEFINDER_FAST_MATH
+ #define SCALEFINDER_FAST_MATH 1
+#endif
+
+namespace fastmath
+{
+#if SCALEFINDER_FAST_MATH
+
+    inline float log2 (float x)
+    {
+        // x = 2^e · m with m in [1, 2); log2(m) by a degree-6 polynomial in (m - 1)
+        uint32_t bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+        float e = (float) ((int32_t) (bits >> 23) - 127);
+        bits = (bits & 0x007fffffu) | 0x3f800000u;
+        float m;
+        std::memcpy (&m, &bits, sizeof (m));
+        float t = m - 1.0f;
+
+        float p = -0.0257915274f;
+        p = p * t + 0.121470734f;
+        p = p * t - 0.277339432f;
+        p = p * t + 0.457157125f;
+        p = p * t - 0.718033397f;
+        p = p * t + 1.44253477f;
+        return e + p * t;
+    }
+
+    inline float exp2 (float x)
+    {
+        // 2^x = 2^i · 2^f with f in [0, 1); 2^f by a degree-5 polynomial
+        x = x < -126.0f ? -126.0f : (x > 127.999f ? 127.999f : x);
+        float fi = std::floor (x);
+        float f  = x - fi;
+
+        float p = 0.00187623362f;
+        p = p * f + 0.00899258918f;
+        p = p * f + 0.0558235929f;
+        p = p * f + 0.240154537f;
+        p = p * f + 0.693152966f;
+        p = p * f + 0.999999927f;
+
+        uint32_t bits = (uint32_t) ((int32_t) fi + 127) << 23;
+        float scale;
+        std::memcpy (&scale, &bits, sizeof (scale));
+        return p * scale;
+    }
+
+    inline float rsqrt (float x)
+    {
+        // Bit-level seed refined by two Newton-Raphson steps
+        uint32_t bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+        bits = 0x5f375a86u - (bits >> 1);
+        float y;
+        std::memcpy (&y, &bits, sizeof (y));
+        y = y * (1.5f - 0.5f * x * y * y);
+        y = y * (1.5f - 0.5f * x * y * y);
+        return y;
+    }
+
+    inline float log   (float x)        { return log2 (x) * 0.693147181f; }
+    inline float log1p (float x)        { return log (1.0f + x); }
+    inline float exp   (float x)        { return exp2 (x * 1.44269504f); }
+    inline float pow   (float b, float e) { return exp2 (e * log2 (b)); }
+
+#else
+
+    // Same saturation as the fast versions, so switching modes never
+    // introduces 0 or inf
+    inline float log2  (float x)        { return std::log2 (x); }
+    inline float exp2  (float x)        { return std::exp2 (x < -126.0f ? -126.0f : (x > 127.999f ? 127.999f : x)); }
+    inline float rsqrt (float x)        { return 1.0f / std::sqrt (x); }
+    inline float log   (float x)        { return std::log (x); }
+    inline float log1p (float x)        { return std::log1p (x); }
+    inline float exp   (float x)        { return std::exp (x < -87.33f ? -87.33f : (x > 88.72f ? 88.72f : x)); }
+    inline float pow   (float b, float e) { return std::pow (b, e); }
+
+#endif
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cmath>
+
+// ── Per-frame spectral kernels ───────────────────────────────────────────
+// The frame loops (silence RMS, window multiply, bin magnitudes) are
+// instantiated with compile-time trip counts for the FFT sizes the analyzer
+// actually uses, so the compiler can fully vectorise them; any other size
+// falls back to the runtime-length loops. Pick a table once per analysis
+// with framekernels::forSize() and call through it per frame.
+namespace framekernels
+{
+    // ── Runtime-length fallbacks ─────────────────────────────────────────
+    inline float sumOfSquares (const float* x, int n)
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < n; ++i)
+            sum += x[i] * x[i];
+        return sum;
+    }
+
+    inline void applyWindow (const float* x, const float* window, float* out, int n)
+    {
+        for (int i = 0; i < n; ++i)
+            out[i] = x[i] * window[i];
+    }
+
+    inline void magnitudes (const float* re, const float* im, float* mag, int numBins)
+    {
+        for (int b = 0; b < numBins; ++b)
+            mag[b] = std::sqrt (re[b] * re[b] + im[b] * im[b]);
+    }
+
+    // ── Fixed-size versions ──────────────────────────────────────────────
+    // Eight independent partial sums let the reduction vectorise without
+    // -ffast-math (float addition is not reassociated otherwise).
+    template <int N>
+    float sumOfSquaresFixed (const float* x, int)
+    {
+        static_assert (N % 8 == 0, "FFT size must be a multiple of 8");
+        float partial[8] = {};
+        for (int i = 0; i < N; i += 8)
+            for (int k = 0; k < 8; ++k)
+                partial[k] += x[i + k] * x[i + k];
+        return ((partial[0] + partial[1]) + (partial[2] + partial[3]))
+             + ((partial[4] + partial[5]) + (partial[6] + partial[7]));
+    }
+
+    template <int N>
+    void applyWindowFixed (const float* x, const float* window, float* out, int)
+    {
+        for (int i = 0; i < N; ++i)
+            out[i] = x[i] * window[i];
+    }
+
+    template <int N>
+    void magnitudesFixed (const float* re, const float* im, float* mag, int)
+    {
+        constexpr int numBins = N / 2 + 1;
+        for (int b = 0; b < numBins; ++b)
+            mag[b] = std::sqrt (re[b] * re[b] + im[b] * im[b]);
+    }
+
+    // One kernel set; the length arguments are ignored by fixed-size entries
+    struct Table
+    {
+        float (*sumOfSquares) (const float* x, int n);
+        void  (*applyWindow)  (const float* x, const float* window, float* out, int n);
+        void  (*magnitudes)   (const float* re, const float* im, float* mag, int numBins);
+        bool  isFixed;
+    };
+
+    template <int N>
+    constexpr Table makeFixed()
+    {
+        return { sumOfSquaresFixed<N>, applyWindowFixed<N>, magnitudesFixed<N>, true };
+    }
+
+    // Kernels for an FFT of fftSize samples: 2048 (tempo), 8192 (Balanced /
+    // default chroma), 4096 and 16384 (Instant / Precise chroma)
+    inline Table forSize (int fftSize)
+    {
+        switch (fftSize)
+        {
+            case 2048:  return makeFixed<2048>();
+            case 4096:  return makeFixed<4096>();
+            case 8192:  return makeFixed<8192>();
+            case 16384: return makeFixed<16384>();
+            default:    return { sumOfSquares, applyWindow, magnitudes, false };
+        }
+    }
+}
@@ -0,0 +1,301 @@
+#pragma once
+#include "MusicTheory.h"
+#include <array>
+#include <cmath>
+#include <vector>
+
+// ── Key profile correlation ──────────────────────────────────────────────
+// The 24 candidate keys are the major and minor profiles rotated onto each
+// root. Each rotated profile is shifted to zero mean and scaled to unit
+// length at compile time, so Pearson r against a chroma vector x reduces to
+//     r[key] = (M · x)[key] / |x - mean(x)|
+// — one 24×12 matrix-vector product per chroma vector, or a 24×12 by 12×N
+// product for N frames. Several profile sets are stacked into one taller
+// matrix so an ensemble costs a single pass over the chroma.
+namespace keyprofiles
+{
+    constexpr int numKeys = 24;                          // 0-11 major, 12-23 minor
+
+    using Profile = std::array<double, 12>;
+    using Matrix  = std::array<Profile, numKeys>;
+
+    constexpr double constexprSqrt (double x)
+    {
+        if (x <= 0.0)
+            return 0.0;
+        double guess = x > 1.0 ? x : 1.0;
+        for (int i = 0; i < 64; ++i)
+            guess = 0.5 * (guess + x / guess);
+        return guess;
+    }
+
+    // profile rotated so index 0 lands on root, zero mean, unit length
+    constexpr Profile normalizedRotation (const Profile& profile, int root)
+    {
+        double mean = 0.0;
+        for (int i = 0; i < 12; ++i) mean += profile[(size_t) i];
+        mean /= 12.0;
+
+        Profile row {};
+        double norm = 0.0;
+        for (int i = 0; i < 12; ++i)
+        {
+            double v = profile[(size_t) i] - mean;
+            row[(size_t) ((i + root) % 12)] = v;
+            norm += v * v;
+        }
+        norm = constexprSqrt (norm);
+        for (int i = 0; i < 12; ++i)
+            row[(size_t) i] /= norm;
+        return row;
+    }
+
+    constexpr Matrix makeMatrix (const Profile& major, const Profile& minor)
+    {
+        Matrix m {};
+        for (int key = 0; key < numKeys; ++key)
+            m[(size_t) key] = normalizedRotation (key < 12 ? major : minor, key % 12);
+        return m;
+    }
+
+    // Albrecht & Shanahan (2013): derived from large corpus analysis of real
+    // music. Best empirical accuracy in benchmarks; significantly better than
+    // Krumhansl (1990) and Temperley (1999). Index 0 = tonic.
+    inline constexpr Profile ALBRECHT_SHANAHAN_MAJOR = {
+        0.238, 0.006, 0.111, 0.006, 0.137, 0.094, 0.016, 0.214, 0.009, 0.080, 0.008, 0.081
+    };
+    inline constexpr Profile ALBRECHT_SHANAHAN_MINOR = {
+        0.220, 0.006, 0.104, 0.123, 0.019, 0.103, 0.012, 0.214, 0.062, 0.022, 0.061, 0.052
+    };
+
+    // Krumhansl & Kessler (1982): probe-tone ratings
+    inline constexpr Profile KRUMHANSL_KESSLER_MAJOR = {
+        6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88
+    };
+    inline constexpr Profile KRUMHANSL_KESSLER_MINOR = {
+        6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17
+    };
+
+    // Temperley (1999): revised from the Kostka-Payne harmony corpus
+    inline constexpr Profile TEMPERLEY_MAJOR = {
+        5.0, 2.0, 3.5, 2.0, 4.5, 4.0, 2.0, 4.5, 2.0, 3.5, 1.5, 4.0
+    };
+    inline constexpr Profile TEMPERLEY_MINOR = {
+        5.0, 2.0, 3.5, 4.5, 2.0, 4.0, 2.0, 4.5, 3.5, 2.0, 1.5, 4.0
+    };
+
+    // Electronic dance music, after Faraldo et al. (2016): flatter than the
+    // classical profiles, with a strong tonic and fifth and a heavier minor third
+    inline constexpr Profile EDM_MAJOR = {
+        0.1652, 0.0475, 0.0829, 0.0669, 0.0999, 0.0927, 0.0529, 0.1316, 0.0522, 0.0744, 0.0694, 0.0643
+    };
+    inline constexpr Profile EDM_MINOR = {
+        0.1724, 0.0400, 0.0761, 0.1261, 0.0531, 0.0920, 0.0400, 0.1330, 0.0854, 0.0599, 0.0575, 0.0644
+    };
+
+    enum ProfileSet { albrechtShanahan, krumhanslKessler, temperley, edm, numProfileSets };
+
+    inline constexpr Matrix ALBRECHT_SHANAHAN = makeMatrix (ALBRECHT_SHANAHAN_MAJOR, ALBRECHT_SHANAHAN_MINOR);
+    inline constexpr Matrix KRUMHANSL_KESSLER = makeMatrix (KRUMHANSL_KESSLER_MAJOR, KRUMHANSL_KESSLER_MINOR);
+    inline constexpr Matrix TEMPERLEY         = makeMatrix (TEMPERLEY_MAJOR, TEMPERLEY_MINOR);
+    inline constexpr Matrix EDM               = makeMatrix (EDM_MAJOR, EDM_MINOR);
+
+    // All sets stacked in ProfileSet order: rows [set * 24, set * 24 + 24)
+    using StackedMatrix = std::array<Profile, (size_t) (numProfileSets * numKeys)>;
+
+    constexpr StackedMatrix makeStacked()
+    {
+        const Matrix* sets[numProfileSets] = { &ALBRECHT_SHANAHAN, &KRUMHANSL_KESSLER, &TEMPERLEY, &EDM };
+        StackedMatrix m {};
+        for (int set = 0; set < numProfileSets; ++set)
+            for (int key = 0; key < numKeys; ++key)
+                m[(size_t) (set * numKeys + key)] = (*sets[set])[(size_t) key];
+        return m;
+    }
+
+    inline constexpr StackedMatrix STACKED = makeStacked();
+
+    // Ensemble vote: weighted mean of each set's r. Equal weights until a
+    // labelled corpus is available to fit them; they must sum to 1 so the
+    // ensemble score stays on the same scale as a single set's r.
+    inline constexpr double ENSEMBLE_WEIGHTS[numProfileSets] = { 0.25, 0.25, 0.25, 0.25 };
+
+    // ── Scale templates ──────────────────────────────────────────────────
+    // One row per (scale, root) from MusicTheory::SCALES, row = scale * 12 +
+    // root: a plain membership mask (1 on scale tones, 0 elsewhere). Masks
+    // only say which pitch classes a scale uses, and the modes of one
+    // collection (C Major, D Dorian, ... B Locrian) share a mask, so the
+    // tonic has to come from elsewhere — bestScale weighs the tonic triad
+    // and the bass line for that.
+    constexpr int numScaleCandidates = MusicTheory::NUM_SCALES * 12;
+    using ScaleMatrix = std::array<Profile, (size_t) numScaleCandidates>;
+
+    constexpr bool hasMajorThird (const ScaleDefinition& scale)
+    {
+        for (int i = 0; i < scale.numNotes; ++i)
+            if (scale.intervals[i] == 4)
+                return true;
+        return false;
+    }
+
+    constexpr Profile scaleProfile (const ScaleDefinition& scale)
+    {
+        Profile p {};
+        for (int i = 0; i < scale.numNotes; ++i)
+            p[(size_t) scale.intervals[i]] = 1.0;
+        return p;
+    }
+
+    constexpr ScaleMatrix makeScaleMatrix()
+    {
+        ScaleMatrix m {};
+        for (int scale = 0; scale < MusicTheory::NUM_SCALES; ++scale)
+            for (int root = 0; root < 12; ++root)
+                m[(size_t) (scale * 12 + root)] = normalizedRotation (scaleProfile (MusicTheory::SCALES[scale]), root);
+        return m;
+    }
+
+    inline constexpr ScaleMatrix SCALE_TEMPLATES = makeScaleMatrix();
+
+    // r = Pearson correlation of each of numFrames chroma vectors (12 values
+    // each, contiguous) against every row of m; writes numFrames × Rows values.
+    // A flat chroma vector correlates 0 with every key.
+    template <size_t Rows>
+    void correlate (const std::array<Profile, Rows>& m, const double* chroma, int numFrames, double* r)
+    {
+        for (int f = 0; f < numFrames; ++f)
+        {
+            const double* x = chroma + (size_t) f * 12;
+            double* out = r + (size_t) f * Rows;
+
+            double mean = 0.0;
+            for (int i = 0; i < 12; ++i) mean += x[i];
+            mean /= 12.0;
+
+            // Row · (x - mean) = row · x, since every row sums to zero
+            double norm = 0.0;
+            for (int i = 0; i < 12; ++i) norm += (x[i] - mean) * (x[i] - mean);
+            double scale = norm > 0.0 ? 1.0 / std::sqrt (norm) : 0.0;
+
+            for (size_t row = 0; row < Rows; ++row)
+            {
+                double sum = 0.0;
+                for (int i = 0; i < 12; ++i)
+                    sum += m[row][(size_t) i] * x[i];
+                out[row] = sum * scale;
+            }
+        }
+    }
+
+    // Ensemble r for numFrames chroma vectors: one stacked product, then the
+    // weighted vote folds each frame's numProfileSets × 24 values down to 24
+    inline void correlateEnsemble (const double* chroma, int numFrames, double* r)
+    {
+        constexpr size_t stackedRows = (size_t) (numProfileSets * numKeys);
+        std::vector<double> stacked ((size_t) numFrames * stackedRows);
+        correlate (STACKED, chroma, numFrames, stacked.data());
+
+        for (int f = 0; f < numFrames; ++f)
+        {
+            const double* in = stacked.data() + (size_t) f * stackedRows;
+            double* out = r + (size_t) f * numKeys;
+            for (int key = 0; key < numKeys; ++key)
+            {
+                double sum = 0.0;
+                for (int set = 0; set < numProfileSets; ++set)
+                    sum += ENSEMBLE_WEIGHTS[set] * in[set * numKeys + key];
+                out[key] = sum;
+            }
+        }
+    }
+
+    // Bass tonic evidence: relative keys and modes share their pitch classes,
+    // but the tonic usually dominates the bass line. bonus[root] = weight ×
+    // (root's share of the bass chroma × 12 − 1), so 0 for an average root
+    // and for a flat or empty bass chroma.
+    inline void bassTonicBonus (const double* bassChroma, double weight, double* bonus)
+    {
+        double total = 0.0;
+        for (int i = 0; i < 12; ++i) total += bassChroma[i];
+        for (int i = 0; i < 12; ++i)
+            bonus[i] = total > 0.0 ? weight * (12.0 * bassChroma[i] / total - 1.0) : 0.0;
+    }
+
+    // Score per unit of tonic-triad prominence in bestScale
+    constexpr double triadTonicWeight = 0.1;
+
+    struct ScaleMatch
+    {
+        int root = 0;
+        int scale = MusicTheory::MAJOR_SCALE;    // MusicTheory::SCALES index
+    };
+
+    // Best (scale, root) for a chroma vector, given its SCALE_TEMPLATES
+    // correlations and the bass bonus above. Every seven-note scale on every
+    // root competes: the mask correlation picks the collection, and within
+    // it the tonic is the root whose triad (degrees 1, 3, 5) stands out of
+    // the chroma most, plus its bass bonus. Major/minor key profiles cannot
+    // make that call for modal material — they hear D Dorian as C Major or
+    // G Major — so this does not start from the detected key.
+    // A five-note mask would win whenever its two missing degrees fall below
+    // the chroma mean, which a strong tonic triad alone causes, so a
+    // pentatonic on the winning root (with the same third) is reported only
+    // when the degrees it drops sit closer to the out-of-scale level than to
+    // its own tones.
+    inline ScaleMatch bestScale (const double* scaleCorr, const double* chroma, const double* tonicBonus)
+    {
+        double mean = 0.0;
+        for (int i = 0; i < 12; ++i) mean += chroma[i];
+        mean /= 12.0;
+        double norm = 0.0;
+        for (int i = 0; i < 12; ++i) norm += (chroma[i] - mean) * (chroma[i] - mean);
+        norm = std::sqrt (norm);
+
+        ScaleMatch match;
+        double bestScore = -1.0e30;
+        for (int scale = 0; scale < MusicTheory::NUM_SCALES; ++scale)
+        {
+            const auto& def = MusicTheory::SCALES[scale];
+            if (def.numNotes != 7)
+                continue;
+
+            for (int root = 0; root < 12; ++root)
+            {
+                double triad = (chroma[root] + chroma[(root + def.intervals[2]) % 12]
+                                + chroma[(root + def.intervals[4]) % 12]) / 3.0;
+                double score = scaleCorr[scale * 12 + root] + tonicBonus[root]
+                             + (norm > 0.0 ? triadTonicWeight * (triad - mean) / norm : 0.0);
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    match = { root, scale };
+                }
+            }
+        }
+
+        const bool isMajor = hasMajorThird (MusicTheory::SCALES[match.scale]);
+        const Profile seven = scaleProfile (MusicTheory::SCALES[match.scale]);
+        for (int scale = 0; scale < MusicTheory::NUM_SCALES; ++scale)
+        {
+            const auto& def = MusicTheory::SCALES[scale];
+            if (def.numNotes != 5 || hasMajorThird (def) != isMajor)
+                continue;
+
+            const Profile five = scaleProfile (def);
+            double tones = 0.0, dropped = 0.0, outside = 0.0;
+            int numDropped = 0, numOutside = 0;
+            bool subset = true;
+            for (int i = 0; i < 12; ++i)
+            {
+                double x = chroma[(match.root + i) % 12];
+                if (five[(size_t) i] > 0.0)       { tones += x; subset = subset && seven[(size_t) i] > 0.0; }
+                else if (seven[(size_t) i] > 0.0) { dropped += x; ++numDropped; }
+                else                              { outside += x; ++numOutside; }
+            }
+            if (subset && numDropped > 0 && numOutside > 0
+                && dropped / numDropped < 0.5 * (tones / def.numNotes + outside / numOutside))
+                return { match.root, scale };
+        }
+        return match;
+    }
+}
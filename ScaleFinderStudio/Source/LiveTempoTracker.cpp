@@ -0,0 +1,277 @@
+#include "LiveTempoTracker.h"
+#include "FastMath.h"
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+LiveTempoTracker::LiveTempoTracker()
+    : juce::Thread ("Live Tempo Tracker")
+{
+    fifoBuffer.assign ((size_t) fifoSize, 0.0f);
+}
+
+LiveTempoTracker::~LiveTempoTracker()
+{
+    release();
+}
+
+void LiveTempoTracker::prepare (double newSampleRate)
+{
+    stopThread (1000);
+
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    // ~86-94 onset frames per second at any common rate
+    hopSize = 512 * juce::jmax (1, (int) std::round (sampleRate / 48000.0));
+    fftSize = hopSize * 2;
+    framesPerSecond = sampleRate / hopSize;
+
+    fft.init ((size_t) fftSize);
+    size_t bins = audiofft::AudioFFT::ComplexSize ((size_t) fftSize);
+    frame.assign ((size_t) fftSize, 0.0f);
+    windowed.assign ((size_t) fftSize, 0.0f);
+    re.assign (bins, 0.0f);
+    im.assign (bins, 0.0f);
+    prevLogMag.assign (bins, 0.0f);
+    window.resize ((size_t) fftSize);
+    for (int i = 0; i < fftSize; ++i)
+        window[(size_t) i] = 0.5f * (1.0f - std::cos (2.0f * (float) M_PI * (float) i / (float) (fftSize - 1)));
+
+    // Resonators: half-energy time of 1.5 s regardless of period, so slow and
+    // fast tempos integrate over the same stretch of music. The bank runs up
+    // to 2 × maxBPM; the upper half only supplies double-time evidence.
+    const double halfLifeFrames = 1.5 * framesPerSecond;
+    combs.clear();
+    for (float bpm = minBPM; bpm <= 2.0f * maxBPM; bpm += 1.0f)
+    {
+        Comb comb;
+        comb.bpm = bpm;
+        comb.delayFrames = (float) (framesPerSecond * 60.0 / bpm);
+        comb.feedback = (float) std::pow (0.5, comb.delayFrames / halfLifeFrames);
+        comb.noiseGain = (1.0f - comb.feedback) / (1.0f + comb.feedback);
+        double octaves = std::log2 (bpm / 120.0);
+        comb.prior = (float) std::exp (-0.5 * octaves * octaves);
+        combs.push_back (comb);
+    }
+    historySize = juce::nextPowerOfTwo ((int) std::ceil (framesPerSecond * 60.0 / minBPM) + 2);
+    combHistory.assign (combs.size() * (size_t) historySize, 0.0f);
+    energyDecay = (float) std::exp (-1.0 / (3.0 * framesPerSecond));   // ~3 s energy average
+
+    resetState();
+    startThread();
+}
+
+void LiveTempoTracker::release()
+{
+    stopThread (1000);
+}
+
+void LiveTempoTracker::resetState()
+{
+    fifo.reset();
+    std::fill (frame.begin(), frame.end(), 0.0f);
+    std::fill (prevLogMag.begin(), prevLogMag.end(), 0.0f);
+    std::fill (combHistory.begin(), combHistory.end(), 0.0f);
+    for (auto& comb : combs) comb.energy = 0.0f;
+    onsetMean = 0.0f;
+    onsetEnergy = 0.0f;
+    onsetTaps.fill (0.0f);
+    writeIndex = 0;
+    framesProcessed = 0;
+    lastVoicedFrame = 0;
+    liveBPM.store (0.0f, std::memory_order_relaxed);
+    liveConfidence.store (0.0f, std::memory_order_relaxed);
+}
+
+// ── Audio thread ─────────────────────────────────────────────────────────
+void LiveTempoTracker::pushSamples (const float* const* channels, int numChannels, int numSamples)
+{
+    if (numChannels <= 0 || numSamples <= 0)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    const float scale = 1.0f / (float) numChannels;
+    auto copyMono = [&] (int dest, int count, int sourceOffset)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            float sum = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                sum += channels[ch][sourceOffset + i];
+            fifoBuffer[(size_t) (dest + i)] = sum * scale;
+        }
+    };
+    copyMono (start1, size1, 0);
+    copyMono (start2, size2, size1);
+
+    fifo.finishedWrite (size1 + size2);
+}
+
+// ── Worker thread ────────────────────────────────────────────────────────
+void LiveTempoTracker::run()
+{
+    const int publishInterval = juce::jmax (1, (int) (framesPerSecond / 4.0));   // ~4 updates / s
+
+    while (! threadShouldExit())
+    {
+        if (fifo.getNumReady() < hopSize)
+        {
+            wait (5);
+            continue;
+        }
+
+        // Slide the analysis frame by one hop
+        std::copy (frame.begin() + hopSize, frame.end(), frame.begin());
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (hopSize, start1, size1, start2, size2);
+        float* dest = frame.data() + (fftSize - hopSize);
+        std::copy (fifoBuffer.begin() + start1, fifoBuffer.begin() + start1 + size1, dest);
+        std::copy (fifoBuffer.begin() + start2, fifoBuffer.begin() + start2 + size2, dest + size1);
+        fifo.finishedRead (size1 + size2);
+
+        processFrame();
+
+        if (framesProcessed % publishInterval == 0)
+            publishEstimate();
+    }
+}
+
+void LiveTempoTracker::processFrame()
+{
+    // Silence tracking on the newest hop
+    float hopEnergy = 0.0f;
+    for (int i = fftSize - hopSize; i < fftSize; ++i)
+        hopEnergy += frame[(size_t) i] * frame[(size_t) i];
+    if (std::sqrt (hopEnergy / (float) hopSize) > 1.0e-3f)
+        lastVoicedFrame = framesProcessed;
+
+    // Log-magnitude spectral flux, as in the offline analyzer
+    for (int i = 0; i < fftSize; ++i)
+        windowed[(size_t) i] = frame[(size_t) i] * window[(size_t) i];
+    fft.fft (windowed.data(), re.data(), im.data());
+
+    float flux = 0.0f;
+    for (size_t b = 1; b < re.size(); ++b)
+    {
+        float mag = std::sqrt (re[b] * re[b] + im[b] * im[b]);
+        float logMag = fastmath::log1p (1000.0f * mag);
+        float diff = logMag - prevLogMag[b];
+        if (diff > 0.0f) flux += diff;
+        prevLogMag[b] = logMag;
+    }
+
+    // Remove the slow loudness trend (~1 s leaky mean). The combs have unity
+    // gain at DC, so any offset left here would lift every tempo equally.
+    onsetMean += 0.01f * (flux - onsetMean);
+    float detrended = flux - onsetMean;
+
+    // Spread each onset over ~5 frames (triangular kernel) so the combs'
+    // fractional-delay interpolation reads a smooth bump instead of a
+    // one-frame spike that linear interpolation would halve
+    for (int k = 4; k > 0; --k)
+        onsetTaps[(size_t) k] = onsetTaps[(size_t) (k - 1)];
+    onsetTaps[0] = detrended;
+    float onset = (onsetTaps[0] + 2.0f * onsetTaps[1] + 3.0f * onsetTaps[2]
+                   + 2.0f * onsetTaps[3] + onsetTaps[4]) / 9.0f;
+    onsetEnergy = energyDecay * onsetEnergy + (1.0f - energyDecay) * onset * onset;
+
+    // Comb bank: y[n] = α·y[n - delay] + (1 - α)·onset, fractional delay by
+    // linear interpolation of each comb's output history
+    const int mask = historySize - 1;
+    for (size_t c = 0; c < combs.size(); ++c)
+    {
+        auto& comb = combs[c];
+        float* history = combHistory.data() + c * (size_t) historySize;
+
+        float pos = (float) writeIndex - comb.delayFrames;
+        int   i0  = (int) std::floor (pos);
+        float frac = pos - (float) i0;
+        float delayed = (1.0f - frac) * history[i0 & mask] + frac * history[(i0 + 1) & mask];
+
+        float y = comb.feedback * delayed + (1.0f - comb.feedback) * onset;
+        history[writeIndex & mask] = y;
+        comb.energy = energyDecay * comb.energy + (1.0f - energyDecay) * y * y;
+    }
+
+    ++writeIndex;
+    ++framesProcessed;
+}
+
+void LiveTempoTracker::publishEstimate()
+{
+    // Wait for a few seconds of audio; fade out after 2 s of silence
+    const bool warmedUp = framesProcessed > (int64_t) (4.0 * framesPerSecond);
+    const bool playing  = framesProcessed - lastVoicedFrame < (int64_t) (2.0 * framesPerSecond);
+    if (! warmedUp || ! playing || combs.empty())
+    {
+        liveConfidence.store (0.0f, std::memory_order_relaxed);
+        return;
+    }
+
+    // Each comb is scored by the energy it adds over an unresonant input:
+    // onset noise alone leaves noiseGain × onset power in every comb, and
+    // that gain grows with the delay, which would otherwise favour slow
+    // tempos. A comb also rings at every multiple of the true period (a
+    // pulse every beat drives the 2- and 3-beat combs just as hard), so each
+    // tempo adds its double-time comb: only the real beat level and the
+    // levels below it have a resonating comb at twice their rate.
+    const size_t numCandidates = (size_t) (maxBPM - minBPM) + 1;
+    auto excess = [this] (size_t c)
+    {
+        return c < combs.size() ? juce::jmax (0.0f, combs[c].energy - combs[c].noiseGain * onsetEnergy) : 0.0f;
+    };
+    auto score = [this, &excess] (size_t c)
+    {
+        return (excess (c) + 0.5f * excess (2 * c + (size_t) minBPM)) * combs[c].prior;
+    };
+
+    size_t best = 0;
+    double total = 0.0;
+    for (size_t c = 0; c < numCandidates; ++c)
+    {
+        total += excess (c);
+        if (score (c) > score (best))
+            best = c;
+    }
+    if (total <= 0.0 || excess (best) <= 0.0f)
+    {
+        liveConfidence.store (0.0f, std::memory_order_relaxed);
+        return;
+    }
+
+    // Parabolic refinement between neighbouring 1-BPM combs
+    float bpm = combs[best].bpm;
+    if (best > 0 && best + 1 < numCandidates)
+    {
+        float a = score (best - 1), b = score (best), c = score (best + 1);
+        float denom = a - 2.0f * b + c;
+        if (denom < 0.0f)
+            bpm += juce::jlimit (-0.5f, 0.5f, 0.5f * (a - c) / denom);
+    }
+
+    // Confidence: how far the winning comb stands above the bank average,
+    // scaled by its margin over the octave rival (the strongest comb at half
+    // or double the tempo). A beat and its double or half both resonate, so
+    // a near tie there means the octave is a guess however sharp the peak.
+    // The margin compares the combs' own prior-weighted resonance: the full
+    // scores share the double-time term (the half-tempo score adds the
+    // winner's own comb), which would tie every clean pulse with its half.
+    float mean = (float) (total / (double) numCandidates);
+    float standout = juce::jlimit (0.0f, 1.0f, (excess (best) - mean) / excess (best));
+
+    auto resonance = [this, &excess] (size_t c) { return excess (c) * combs[c].prior; };
+    float rival = 0.0f;
+    for (float octave : { 0.5f, 2.0f })
+    {
+        int centre = (int) std::round (bpm * octave - minBPM);
+        for (int c = juce::jmax (0, centre - 1); c <= juce::jmin ((int) numCandidates - 1, centre + 1); ++c)
+            rival = juce::jmax (rival, resonance ((size_t) c));
+    }
+    float confidence = standout * juce::jlimit (0.0f, 1.0f, 1.0f - rival / resonance (best));
+
+    liveBPM.store (bpm, std::memory_order_relaxed);
+    liveConfidence.store (confidence, std::memory_order_relaxed);
+}
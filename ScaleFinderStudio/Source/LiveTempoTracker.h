@@ -0,0 +1,81 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+// ── Live tempo tracker ───────────────────────────────────────────────────
+// Causal tempo estimate for audio arriving at the plugin input. The audio
+// thread only mixes each block to mono and copies it into a lock-free FIFO;
+// a worker thread turns it into a spectral-flux onset signal and feeds a
+// bank of recursive comb filters (Scheirer 1998), one per candidate tempo.
+// The comb that resonates most (weighted by a tempo prior) is published
+// through atomics that the UI can poll at any rate.
+class LiveTempoTracker : private juce::Thread
+{
+public:
+    LiveTempoTracker();
+    ~LiveTempoTracker() override;
+
+    // Message thread: (re)start the worker for a new sample rate
+    void prepare (double sampleRate);
+    void release();
+
+    // Audio thread: wait-free; samples are dropped if the worker falls behind
+    void pushSamples (const float* const* channels, int numChannels, int numSamples);
+
+    // Any thread
+    float getBPM() const        { return liveBPM.load (std::memory_order_relaxed); }
+    float getConfidence() const { return liveConfidence.load (std::memory_order_relaxed); }
+
+    static constexpr float minBPM = 60.0f;
+    static constexpr float maxBPM = 200.0f;
+
+    // Confidence from which an estimate is worth showing. A wrong octave
+    // stays well below it; a clean, steady beat lands around 0.3-0.6.
+    static constexpr float displayThreshold = 0.25f;
+
+private:
+    void run() override;
+    void resetState();
+    void processFrame();
+    void publishEstimate();
+
+    // Audio → worker hand-off (single producer, single consumer)
+    static constexpr int fifoSize = 1 << 16;
+    juce::AbstractFifo fifo { fifoSize };
+    std::vector<float> fifoBuffer;
+
+    // Onset analysis (worker thread only)
+    double sampleRate = 44100.0;
+    int hopSize = 512, fftSize = 1024;
+    double framesPerSecond = 86.0;
+    audiofft::AudioFFT fft;
+    std::vector<float> frame, window, windowed, re, im, prevLogMag;
+    float onsetMean = 0.0f;
+    float onsetEnergy = 0.0f;
+    std::array<float, 5> onsetTaps {};
+
+    // Comb filter bank: one resonator per integer BPM, minBPM .. 2 × maxBPM
+    struct Comb
+    {
+        float bpm = 0.0f;
+        float delayFrames = 0.0f;
+        float feedback = 0.0f;       // α = 0.5^(delay / half-life)
+        float noiseGain = 0.0f;      // Output power per unit of white input power
+        float prior = 1.0f;          // Log-Gaussian tempo prior around 120 BPM
+        float energy = 0.0f;
+    };
+    std::vector<Comb> combs;
+    std::vector<float> combHistory;  // combs.size() × historySize circular outputs
+    int historySize = 0;
+    int writeIndex = 0;
+    float energyDecay = 0.0f;
+
+    int64_t framesProcessed = 0;
+    int64_t lastVoicedFrame = 0;
+
+    std::atomic<float> liveBPM { 0.0f };
+    std::atomic<float> liveConfidence { 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LiveTempoTracker)
+};
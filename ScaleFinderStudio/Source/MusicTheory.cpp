@@ -16,10 +16,6 @@ const Pitch MusicTheory::PITCHES[12] = {
     { "B",  "B"  }
 };
 
-// ── Scale intervals ───────────────────────────────────────────────────────
-const int MusicTheory::MAJOR_INTERVALS[7] = { 0, 2, 4, 5, 7, 9, 11 };
-const int MusicTheory::MINOR_INTERVALS[7] = { 0, 2, 3, 5, 7, 8, 10 };
-
 // ── Enharmonic table (pitch-class → sharp/flat names) ─────────────────────
 struct EnharmonicPair { juce::String sharp; juce::String flat; };
 
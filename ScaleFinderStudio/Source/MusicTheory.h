@@ -27,6 +27,14 @@ struct KeyInfo
     int root;                    // 0-11
 };
 
+// Scale shape as intervals above the root (up to 7 notes)
+struct ScaleDefinition
+{
+    const char* name;      // "Dorian", "Major Pentatonic", ...
+    int intervals[7];
+    int numNotes;
+};
+
 struct KeyResult
 {
     juce::String status;           // "all-visible", "all", "some", "none"
@@ -37,8 +45,27 @@ class MusicTheory
 {
 public:
     static const Pitch PITCHES[12];
-    static const int MAJOR_INTERVALS[7];
-    static const int MINOR_INTERVALS[7];
+
+    // Scales the audio analyzer can detect. Major and Minor come first so
+    // their indices match the key names used everywhere else, and they are
+    // the single definition of the major / natural minor intervals.
+    static constexpr ScaleDefinition SCALES[] = {
+        { "Major",            { 0, 2, 4, 5, 7, 9, 11 }, 7 },
+        { "Minor",            { 0, 2, 3, 5, 7, 8, 10 }, 7 },
+        { "Dorian",           { 0, 2, 3, 5, 7, 9, 10 }, 7 },
+        { "Phrygian",         { 0, 1, 3, 5, 7, 8, 10 }, 7 },
+        { "Lydian",           { 0, 2, 4, 6, 7, 9, 11 }, 7 },
+        { "Mixolydian",       { 0, 2, 4, 5, 7, 9, 10 }, 7 },
+        { "Harmonic Minor",   { 0, 2, 3, 5, 7, 8, 11 }, 7 },
+        { "Melodic Minor",    { 0, 2, 3, 5, 7, 9, 11 }, 7 },
+        { "Major Pentatonic", { 0, 2, 4, 7, 9 },        5 },
+        { "Minor Pentatonic", { 0, 3, 5, 7, 10 },       5 }
+    };
+    static constexpr int NUM_SCALES = (int) (sizeof (SCALES) / sizeof (SCALES[0]));
+    static constexpr int MAJOR_SCALE = 0, MINOR_SCALE = 1;   // Indices into SCALES
+
+    static constexpr const int (&MAJOR_INTERVALS)[7] = SCALES[MAJOR_SCALE].intervals;
+    static constexpr const int (&MINOR_INTERVALS)[7] = SCALES[MINOR_SCALE].intervals;
 
     static std::vector<KeyInfo> allKeys();
     static KeyResult getPossibleKeys (const std::set<int>& selected);
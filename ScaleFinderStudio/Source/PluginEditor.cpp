@@ -1,4 +1,5 @@
 #include "PluginEditor.h"
+#include "TempoDisplay.h"
 
 #if JucePlugin_Build_Standalone
  #include <juce_audio_plugin_client/Standalone/juce_StandaloneFilterWindow.h>
@@ -642,6 +643,10 @@ void TapTempoPopup::resized()
 
     float applyY = nudgeY + nudgeH + 10.0f;
     applyBounds = juce::Rectangle<float> (12.0f, applyY, w - 24.0f, 26.0f);
+
+    float hostY = applyBounds.getBottom() + 8.0f;
+    followHostBounds = juce::Rectangle<float> (12.0f,                    hostY, nudgeW, 20.0f);
+    hostClickBounds  = juce::Rectangle<float> (12.0f + nudgeW + 8.0f,   hostY, nudgeW, 20.0f);
 }
 
 void TapTempoPopup::paint (juce::Graphics& g)
@@ -789,6 +794,24 @@ void TapTempoPopup::paint (juce::Graphics& g)
         g.setColour (hasValue ? Theme::textPrimary() : Theme::textMuted());
         g.drawText ("Apply Tempo", applyBounds, juce::Justification::centred);
     }
+
+    // ── Host toggles ───────────────────────────────────────────────────
+    auto drawToggle = [&] (juce::Rectangle<float> bounds, const juce::String& label, bool on, bool hovered)
+    {
+        juce::Path pill;
+        pill.addRoundedRectangle (bounds.reduced (0.5f), bounds.getHeight() * 0.5f);
+        g.setColour (on ? Theme::accentPurple().withAlpha (hovered ? 0.45f : 0.3f)
+                        : (hovered ? juce::Colour (0xff2C3050) : juce::Colour (0xff1E2235)));
+        g.fillPath (pill);
+        g.setColour (on ? Theme::accentPurple() : Theme::borderSubtle());
+        g.strokePath (pill, juce::PathStrokeType (0.75f));
+        g.setFont (juce::FontOptions (10.0f));
+        g.setColour (on || hovered ? Theme::textPrimary() : Theme::textMuted());
+        g.drawText (label, bounds, juce::Justification::centred);
+    };
+
+    drawToggle (followHostBounds, "follow host", processorRef.followHostTempo.load(), hoveredArea == kFollowHost);
+    drawToggle (hostClickBounds,  "host click",  processorRef.hostMetronome.load(),   hoveredArea == kHostClick);
 }
 
 void TapTempoPopup::timerCallback()
@@ -823,7 +846,7 @@ void TapTempoPopup::handleTap()
     }
 
     flashAlpha = 1.0f;
-    processorRef.requestMetronomeClick();
+    processorRef.requestMetronomeClick (now);
     repaint();
 }
 
@@ -833,6 +856,8 @@ TapTempoPopup::HitArea TapTempoPopup::hitTestArea (juce::Point<float> pos) const
     if (applyBounds.contains (pos))     return kApply;
     if (nudgeMinusBounds.contains (pos)) return kNudgeMinus;
     if (nudgePlusBounds.contains (pos))  return kNudgePlus;
+    if (followHostBounds.contains (pos)) return kFollowHost;
+    if (hostClickBounds.contains (pos))  return kHostClick;
 
     float cx = tapCircleBounds.getCentreX();
     float cy = tapCircleBounds.getCentreY();
@@ -861,6 +886,14 @@ void TapTempoPopup::mouseDown (const juce::MouseEvent& e)
         case kClose:
             if (onClose) onClose();
             break;
+        case kFollowHost:
+            processorRef.followHostTempo.store (! processorRef.followHostTempo.load());
+            repaint();
+            break;
+        case kHostClick:
+            processorRef.hostMetronome.store (! processorRef.hostMetronome.load());
+            repaint();
+            break;
         default: break;
     }
 }
@@ -3699,10 +3732,34 @@ void ScaleFinderEditor::filesDropped (const juce::StringArray& files, int, int)
 
 void ScaleFinderEditor::updateBpmPillDisplay()
 {
-    // Priority: manual typed > analyzed > default
-    float displayBPM  = manualBPM > 0.0f ? manualBPM : audioAnalyzer.getDetectedBPM();
-    float bpmConf     = manualBPM > 0.0f ? 1.0f : audioAnalyzer.getDetectedBPMConfidence();
-    bool  isManual    = (manualBPM > 0.0f);
+    // Priority: manual typed > playing host > live input > analyzed > stopped host
+    auto host = processorRef.getHostTransport();
+    tempodisplay::Readings readings;
+    readings.manualBPM      = manualBPM;
+    readings.hostBPM        = (float) host.bpm;
+    readings.hostPlaying    = host.isPlaying;
+    readings.followHost     = processorRef.followHostTempo.load (std::memory_order_relaxed);
+    readings.liveBPM        = processorRef.getLiveBPM();
+    readings.liveConfidence = processorRef.getLiveBPMConfidence();
+    readings.fileBPM        = audioAnalyzer.getDetectedBPM();
+    readings.fileConfidence = audioAnalyzer.getDetectedBPMConfidence();
+
+    auto  choice      = tempodisplay::choose (readings);
+    bool  isManual    = choice.source == tempodisplay::Source::manual;
+    float displayBPM  = choice.bpm;
+    float bpmConf     = choice.confidence;
+
+    // Host and file tempos are separate sources: name the one shown and
+    // list the other when it differs
+    juce::String sourceText = isManual                                    ? "Tapped tempo"
+                            : choice.source == tempodisplay::Source::host ? "Host tempo"
+                            : choice.source == tempodisplay::Source::live ? "Live input tempo"
+                                                                          : "File tempo";
+    if (choice.source != tempodisplay::Source::host && readings.hostBPM > 0.0f)
+        sourceText += " (host " + juce::String ((int) std::round (readings.hostBPM)) + " BPM)";
+    if (choice.source != tempodisplay::Source::file && readings.fileBPM > 0.0f)
+        sourceText += " (file " + juce::String ((int) std::round (readings.fileBPM)) + " BPM)";
+    bpmPill.setTooltip (sourceText + " - click to tap tempo");
 
     if (displayBPM >= 50.0f && displayBPM <= 220.0f)
     {
@@ -3733,7 +3790,7 @@ void ScaleFinderEditor::showTapTempoPopup()
     tapTempoPopup = std::make_unique<TapTempoPopup> (processorRef);
 
     // Size
-    constexpr int popW = 175, popH = 242;
+    constexpr int popW = 175, popH = 270;
 
     // Position: above the bpmPill, horizontally centred on it
     auto pillBounds = bpmPill.getBounds();
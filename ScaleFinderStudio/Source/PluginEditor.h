@@ -348,7 +348,7 @@ private:
     void timerCallback() override;
     void handleTap();
 
-    enum HitArea { kNone = 0, kTap, kNudgeMinus, kNudgePlus, kApply, kClose };
+    enum HitArea { kNone = 0, kTap, kNudgeMinus, kNudgePlus, kApply, kClose, kFollowHost, kHostClick };
     HitArea hitTestArea (juce::Point<float> pos) const;
 
     ScaleFinderProcessor& processorRef;
@@ -364,6 +364,8 @@ private:
     juce::Rectangle<float> nudgePlusBounds;
     juce::Rectangle<float> applyBounds;
     juce::Rectangle<float> closeBounds;
+    juce::Rectangle<float> followHostBounds;
+    juce::Rectangle<float> hostClickBounds;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TapTempoPopup)
 };
@@ -3,6 +3,7 @@
 
 ScaleFinderProcessor::ScaleFinderProcessor()
     : AudioProcessor (BusesProperties()
+                          .withInput  ("Input",  juce::AudioChannelSet::stereo(), false)
                           .withOutput ("Output", juce::AudioChannelSet::stereo(), true))
 {
     recomputeResult();
@@ -27,16 +28,47 @@ void ScaleFinderProcessor::prepareToPlay (double sampleRate, int samplesPerBlock
 {
     pianoSynth.prepareToPlay (sampleRate, samplesPerBlock);
     currentSampleRate = sampleRate;
-    metronomeClickSamplesLeft.store (0, std::memory_order_relaxed);
+
+    // Metronome click: 60 ms 880 Hz tone with an exponential decay, rendered
+    // once so processBlock only copies it
+    clickTable.resize ((size_t) (sampleRate * 0.06));
+    const float clickLength = (float) clickTable.size();
+    for (size_t i = 0; i < clickTable.size(); ++i)
+    {
+        float t = (float) i / clickLength;
+        clickTable[i] = std::cos (juce::MathConstants<float>::twoPi * 880.0f * (float) i / (float) sampleRate)
+                        * std::exp (-t * 20.0f) * 0.4f;
+    }
+    clickPlayhead = -1;
+    numPendingClicks = 0;
+    samplesRendered = 0;
+    lastBlockStartMs = 0.0;
+    clickLatencySamples = (double) juce::jmax (1, samplesPerBlock);
+
+    // The tempo worker only runs while something can feed it
+    if (getMainBusNumInputChannels() > 0)
+        liveTempoTracker.prepare (sampleRate);
+    else
+        liveTempoTracker.release();
 }
 
-void ScaleFinderProcessor::releaseResources() {}
+void ScaleFinderProcessor::releaseResources()
+{
+    liveTempoTracker.release();
+}
 
 bool ScaleFinderProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
     if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
         && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
         return false;
+
+    // Optional input (live tempo tracking): off, mono or stereo
+    auto input = layouts.getMainInputChannelSet();
+    if (! input.isDisabled()
+        && input != juce::AudioChannelSet::mono()
+        && input != juce::AudioChannelSet::stereo())
+        return false;
     return true;
 }
 
@@ -45,6 +77,17 @@ void ScaleFinderProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                          juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+
+    const int64_t blockStart   = samplesRendered;
+    updateClickClock (blockStart, juce::Time::getMillisecondCounterHiRes(), buffer.getNumSamples());
+    const int hostBeatSample = readHostTransport (buffer.getNumSamples());
+
+    // Hand live input to the tempo worker before the buffer becomes output
+    if (int numInputs = getMainBusNumInputChannels(); numInputs > 0)
+        liveTempoTracker.pushSamples (buffer.getArrayOfReadPointers(),
+                                      juce::jmin (numInputs, buffer.getNumChannels()),
+                                      buffer.getNumSamples());
+
     buffer.clear();
 
     // Track EXTERNAL MIDI notes for scale detection (toggle on repeat)
@@ -76,27 +119,24 @@ void ScaleFinderProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     // Render piano audio (includes both external + GUI MIDI)
     pianoSynth.renderNextBlock (buffer, midiMessages, 0, buffer.getNumSamples());
 
-    // Metronome click synthesis (for tap tempo popup — synthesised directly into the output)
+    // Metronome clicks (tap tempo popup, or host beats when hostMetronome
+    // is on), each started at its own sample rather than at the block start
     {
-        int samplesLeft = metronomeClickSamplesLeft.load (std::memory_order_relaxed);
-        if (samplesLeft > 0)
+        // A tap maps to the sample it happened at plus the click latency: it
+        // is only seen once the next callback comes, and a delay that stays
+        // put keeps the spacing between taps intact
+        double tapMs;
+        while (tapClickRing.pop (tapMs))
         {
-            float totalSamples = (float) (currentSampleRate * 0.06);   // 60 ms click
-            int   offset       = (int) totalSamples - samplesLeft;      // position inside click
-            int   toRender     = juce::jmin (samplesLeft, buffer.getNumSamples());
-
-            for (int s = 0; s < toRender; ++s)
-            {
-                float t     = (float) (offset + s) / totalSamples;
-                float click = std::cos (juce::MathConstants<float>::twoPi
-                                        * 880.0f * (float) (offset + s)
-                                        / (float) currentSampleRate)
-                              * std::exp (-t * 20.0f) * 0.4f;
-                for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
-                    buffer.addSample (ch, s, click);
-            }
-            metronomeClickSamplesLeft.fetch_sub (toRender, std::memory_order_relaxed);
+            auto tapSample = (int64_t) std::llround (tapMs * currentSampleRate / 1000.0 + clockOffsetSamples
+                                                     + clickLatencySamples);
+            scheduleClick (juce::jmax (blockStart, tapSample));
         }
+
+        if (hostBeatSample >= 0)
+            scheduleClick (blockStart + hostBeatSample);
+
+        renderClicks (buffer, blockStart);
     }
 
     // Apply master volume / mute
@@ -104,12 +144,143 @@ void ScaleFinderProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                                           : masterVolume.load (std::memory_order_relaxed);
     if (gain != 1.0f)
         buffer.applyGain (gain);
+
+    samplesRendered += buffer.getNumSamples();
+}
+
+// Keeps the wall clock → sample mapping for taps on the audio thread's own
+// counter. A callback never comes later than its audio is due, so every
+// block start (blockStart − time · rate) bounds the offset from above and
+// the smallest one seen is the tightest; a host that renders several blocks
+// in one burst is read by the first block of the burst. The latency covers
+// the rest: the furthest a block started past the mapped time of the
+// callback before it, which is where a tap waiting for this block can lie.
+// The offset rises 1 ms per second to follow drift between the two clocks,
+// and the latency sinks 1% per second so a one-off stall wears off.
+void ScaleFinderProcessor::updateClickClock (int64_t blockStart, double blockStartMs, int numSamples)
+{
+    const double samplesPerMs = currentSampleRate / 1000.0;
+    const double offset = (double) blockStart - blockStartMs * samplesPerMs;
+
+    if (lastBlockStartMs <= 0.0)
+    {
+        clockOffsetSamples = offset;
+        clickLatencySamples = juce::jmax (clickLatencySamples, (double) numSamples);
+    }
+    else
+    {
+        const double elapsedMs = juce::jmax (0.0, blockStartMs - lastBlockStartMs);
+        clockOffsetSamples  = juce::jmin (offset, clockOffsetSamples + 1.0e-3 * elapsedMs * samplesPerMs);
+        clickLatencySamples = juce::jmax ((double) blockStart - (lastBlockStartMs * samplesPerMs + clockOffsetSamples),
+                                          clickLatencySamples * (1.0 - 1.0e-5 * elapsedMs));
+    }
+    lastBlockStartMs = blockStartMs;
+}
+
+void ScaleFinderProcessor::scheduleClick (int64_t startSample)
+{
+    if (numPendingClicks < (int) pendingClicks.size())
+        pendingClicks[(size_t) numPendingClicks++] = startSample;
+}
+
+// Mixes the click table into the block, restarting it at every scheduled
+// click that falls inside; clicks past the block stay pending
+void ScaleFinderProcessor::renderClicks (juce::AudioBuffer<float>& buffer, int64_t blockStart)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int tableSize  = (int) clickTable.size();
+
+    int pos = 0;
+    while (pos < numSamples)
+    {
+        int next = numSamples, nextIndex = -1;
+        for (int i = 0; i < numPendingClicks; ++i)
+        {
+            auto offset = juce::jmax ((int64_t) pos, pendingClicks[(size_t) i] - blockStart);
+            if (offset < (int64_t) next)
+            {
+                next = (int) offset;
+                nextIndex = i;
+            }
+        }
+
+        if (clickPlayhead >= 0)
+        {
+            int toRender = juce::jmin (next - pos, tableSize - clickPlayhead);
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                buffer.addFrom (ch, pos, clickTable.data() + clickPlayhead, toRender);
+            clickPlayhead += toRender;
+            if (clickPlayhead >= tableSize)
+                clickPlayhead = -1;
+        }
+
+        if (nextIndex >= 0)
+        {
+            clickPlayhead = 0;
+            pendingClicks[(size_t) nextIndex] = pendingClicks[(size_t) --numPendingClicks];
+        }
+        pos = next;
+    }
+}
+
+// Publishes the host's tempo, meter and position; returns the sample in this
+// block where a host beat falls when hostMetronome is on, otherwise -1
+int ScaleFinderProcessor::readHostTransport (int numSamples)
+{
+    auto* playHead = getPlayHead();
+    auto position  = playHead != nullptr ? playHead->getPosition() : juce::Optional<juce::AudioPlayHead::PositionInfo>();
+    if (! position.hasValue())
+    {
+        hostBPM.store (0.0, std::memory_order_relaxed);
+        hostIsPlaying.store (false, std::memory_order_relaxed);
+        return -1;
+    }
+
+    double bpm = position->getBpm().orFallback (0.0);
+    int numerator = 4, denominator = 4;
+    if (auto timeSig = position->getTimeSignature())
+    {
+        numerator   = juce::jmax (1, timeSig->numerator);
+        denominator = juce::jmax (1, timeSig->denominator);
+    }
+    auto ppq = position->getPpqPosition();
+    bool playing = position->getIsPlaying();
+
+    hostBPM.store (bpm, std::memory_order_relaxed);
+    hostTimeSigNumerator.store (numerator, std::memory_order_relaxed);
+    hostTimeSigDenominator.store (denominator, std::memory_order_relaxed);
+    hostPPQPosition.store (ppq.orFallback (0.0), std::memory_order_relaxed);
+    hostIsPlaying.store (playing, std::memory_order_relaxed);
+
+    if (! hostMetronome.load (std::memory_order_relaxed) || ! playing || bpm <= 0.0 || ! ppq.hasValue())
+        return -1;
+
+    // Beats follow the denominator (quarters in x/4, eighths in x/8). Half a
+    // sample of slack makes a beat that rounds onto the next block's first
+    // sample land there exactly once.
+    double beatLength     = 4.0 / (double) denominator;                  // In quarter notes
+    double samplesPerBeat = currentSampleRate * 60.0 / bpm * beatLength;
+    double beatPosition   = *ppq / beatLength;
+    double nextBeat       = std::ceil (beatPosition - 0.5 / samplesPerBeat);
+    auto   beatSample     = (int) std::llround ((nextBeat - beatPosition) * samplesPerBeat);
+    beatSample = juce::jmax (0, beatSample);
+    return beatSample < numSamples ? beatSample : -1;
+}
+
+ScaleFinderProcessor::HostTransport ScaleFinderProcessor::getHostTransport() const
+{
+    HostTransport t;
+    t.bpm                = hostBPM.load (std::memory_order_relaxed);
+    t.timeSigNumerator   = hostTimeSigNumerator.load (std::memory_order_relaxed);
+    t.timeSigDenominator = hostTimeSigDenominator.load (std::memory_order_relaxed);
+    t.ppqPosition        = hostPPQPosition.load (std::memory_order_relaxed);
+    t.isPlaying          = hostIsPlaying.load (std::memory_order_relaxed);
+    return t;
 }
 
-void ScaleFinderProcessor::requestMetronomeClick()
+void ScaleFinderProcessor::requestMetronomeClick (double tapTimeMs)
 {
-    int clickSamples = (int) (currentSampleRate * 0.06);   // 60 ms
-    metronomeClickSamplesLeft.store (clickSamples, std::memory_order_release);
+    tapClickRing.push (tapTimeMs);
 }
 
 // ── UI-thread API (all called from message thread) ───────────────────────
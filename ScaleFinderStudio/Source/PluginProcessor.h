@@ -2,6 +2,8 @@
 #include <JuceHeader.h>
 #include "MusicTheory.h"
 #include "PianoSynth.h"
+#include "LiveTempoTracker.h"
+#include <array>
 #include <atomic>
 #include <set>
 
@@ -43,6 +45,40 @@ private:
     std::atomic<int> writePos { 0 };
 };
 
+// ── Lock-free tap time ring buffer (SPSC: GUI writes, audio reads) ──────
+// Wall-clock times (Time::getMillisecondCounterHiRes) of metronome taps;
+// the audio thread turns each one into a sample position.
+class TapTimeRingBuffer
+{
+public:
+    static constexpr int capacity = 16;
+
+    void push (double timeMs)
+    {
+        int w = writePos.load (std::memory_order_relaxed);
+        int next = (w + 1) % capacity;
+        if (next == readPos.load (std::memory_order_acquire))
+            return; // Full — drop tap
+        times[w] = timeMs;
+        writePos.store (next, std::memory_order_release);
+    }
+
+    bool pop (double& out)
+    {
+        int r = readPos.load (std::memory_order_relaxed);
+        if (r == writePos.load (std::memory_order_acquire))
+            return false; // Empty
+        out = times[r];
+        readPos.store ((r + 1) % capacity, std::memory_order_release);
+        return true;
+    }
+
+private:
+    double times[capacity] {};
+    std::atomic<int> readPos { 0 };
+    std::atomic<int> writePos { 0 };
+};
+
 // ── Processor ────────────────────────────────────────────────────────────
 class ScaleFinderProcessor : public juce::AudioProcessor
 {
@@ -86,8 +122,29 @@ public:
     void togglePitchClassOn (int pitchClass);
     void togglePitchClassOff (int pitchClass);
 
-    // Tap tempo metronome click (called from UI thread; synthesised in processBlock)
-    void requestMetronomeClick();
+    // Tap tempo metronome click (called from UI thread with the tap's
+    // Time::getMillisecondCounterHiRes; played one block after the tap)
+    void requestMetronomeClick (double tapTimeMs);
+
+    // ── Host transport (published by the audio thread every block) ──────
+    struct HostTransport
+    {
+        double bpm = 0.0;                // 0 = host gives no tempo (e.g. standalone)
+        int    timeSigNumerator = 4;
+        int    timeSigDenominator = 4;
+        double ppqPosition = 0.0;        // Quarter notes since the start of the timeline
+        bool   isPlaying = false;
+    };
+    HostTransport getHostTransport() const;
+
+    // Tap tempo popup toggles: click on every host beat while the transport
+    // runs (sample-accurate), and show the host tempo even while it is stopped
+    std::atomic<bool> hostMetronome { false };
+    std::atomic<bool> followHostTempo { false };
+
+    // Tempo of audio on the optional input bus (0 = bus disabled / no estimate yet)
+    float getLiveBPM() const           { return liveTempoTracker.getBPM(); }
+    float getLiveBPMConfidence() const { return liveTempoTracker.getConfidence(); }
 
     // ── Lock-free bitmask accessors ──────────────────────────────────────
     uint16_t getAccumulatedBits() const { return accumulatedBits.load (std::memory_order_acquire); }
@@ -126,9 +183,38 @@ private:
     MidiRingBuffer guiMidiRing;
     int lastGUINote = -1;
 
-    // Metronome click synthesis state
+    // Metronome click: a 60 ms wavetable rendered in prepareToPlay, started
+    // at sample positions on a running sample counter (audio thread only)
     double currentSampleRate = 44100.0;
-    std::atomic<int> metronomeClickSamplesLeft { 0 };
+    std::vector<float> clickTable;
+    TapTimeRingBuffer tapClickRing;
+    std::array<int64_t, 8> pendingClicks {};   // Scheduled start samples
+    int     numPendingClicks = 0;
+    int     clickPlayhead = -1;                // Index into clickTable; -1 = silent
+    int64_t samplesRendered = 0;               // Sample position of the current block
+
+    // Wall clock → sample counter: a tap at timeMs sits at sample
+    // timeMs · rate / 1000 + clockOffsetSamples. The offset follows the
+    // block starts (audio thread only, see updateClickClock).
+    double  clockOffsetSamples = 0.0;
+    double  lastBlockStartMs = 0.0;            // 0 = no block since prepareToPlay
+    double  clickLatencySamples = 512.0;       // Tap → click delay: longest recent wait for a callback
+
+    void updateClickClock (int64_t blockStart, double blockStartMs, int numSamples);
+    void scheduleClick (int64_t startSample);
+    void renderClicks (juce::AudioBuffer<float>& buffer, int64_t blockStart);
+
+    // Host transport snapshot (written in processBlock only)
+    std::atomic<double> hostBPM { 0.0 };
+    std::atomic<int>    hostTimeSigNumerator { 4 };
+    std::atomic<int>    hostTimeSigDenominator { 4 };
+    std::atomic<double> hostPPQPosition { 0.0 };
+    std::atomic<bool>   hostIsPlaying { false };
+
+    int readHostTransport (int numSamples);
+
+    // Live input tempo (worker thread fed from processBlock)
+    LiveTempoTracker liveTempoTracker;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScaleFinderProcessor)
 };
@@ -0,0 +1,46 @@
+#pragma once
+#include "LiveTempoTracker.h"
+
+// ── BPM pill source selection ────────────────────────────────────────────
+// Picks which of the tempo readings the BPM pill shows. Kept free of UI
+// types so the choice can be checked without building an editor.
+namespace tempodisplay
+{
+    enum class Source { manual, host, live, file };
+
+    struct Readings
+    {
+        float manualBPM = 0.0f;                  // Typed or tapped; 0 = none
+        float hostBPM = 0.0f;                    // 0 = host gives no tempo
+        bool  hostPlaying = false;
+        bool  followHost = false;                // Prefer the host tempo even while stopped
+        float liveBPM = 0.0f, liveConfidence = 0.0f;
+        float fileBPM = 0.0f, fileConfidence = 0.0f;
+    };
+
+    struct Choice
+    {
+        Source source = Source::file;
+        float  bpm = 0.0f;
+        float  confidence = 0.0f;
+    };
+
+    // Priority: manual typed > playing host > live input > analyzed file >
+    // stopped host. Every DAW reports a tempo, so a stopped transport only
+    // says what the session is set to and must not hide the file's own
+    // tempo unless the user asks to follow the host. The live estimate only
+    // takes over once it clears the tracker's own display threshold.
+    inline Choice choose (const Readings& r)
+    {
+        const bool hasHost = r.hostBPM > 0.0f;
+        if (r.manualBPM > 0.0f)
+            return { Source::manual, r.manualBPM, 1.0f };
+        if (hasHost && (r.hostPlaying || r.followHost))
+            return { Source::host, r.hostBPM, 1.0f };
+        if (r.liveBPM > 0.0f && r.liveConfidence >= LiveTempoTracker::displayThreshold)
+            return { Source::live, r.liveBPM, r.liveConfidence };
+        if (r.fileBPM > 0.0f || ! hasHost)
+            return { Source::file, r.fileBPM, r.fileConfidence };
+        return { Source::host, r.hostBPM, 1.0f };
+    }
+}
@@ -0,0 +1,133 @@
+#include <JuceHeader.h>
+#include "../Source/AudioAnalyzer.h"
+
+#if JUCE_UNIT_TESTS
+
+// ── Analysis regression ──────────────────────────────────────────────────
+// A small labelled corpus rendered in-process: a one-chord-per-bar
+// progression with harmonics and a root bass over a kick / snare / hat
+// loop. Each item is written to a 16-bit WAV and run through analyzeFile
+// like the editor does, and key and BPM must match the labels. Numeric
+// shortcuts (FastMath, the single-precision FFT front end) are meant to be
+// invisible; building with SCALEFINDER_FAST_MATH=0 must pass the same
+// labels.
+class AnalysisRegressionTests : public juce::UnitTest
+{
+public:
+    AnalysisRegressionTests() : juce::UnitTest ("Analysis regression", "ScaleFinder") {}
+
+    struct Chord { int root; bool isMajor; };
+    struct Item  { const char* key; float bpm; std::vector<Chord> progression; };
+
+    // Tonic first and last in each bar cycle, with the dominant (major in
+    // the minor keys) to settle the tonic the way real songs do
+    static std::vector<Item> corpus()
+    {
+        return {
+            { "C Major",   120.0f, { { 0, true },  { 7, true },  { 9, false }, { 5, true } } },
+            { "A Minor",    97.0f, { { 9, false }, { 2, false }, { 9, false }, { 4, true } } },
+            { "G Major",   128.0f, { { 7, true },  { 0, true },  { 2, true },  { 7, true } } },
+            { "E Minor",    84.0f, { { 4, false }, { 9, false }, { 4, false }, { 11, true } } },
+            { "F Major",   110.0f, { { 5, true },  { 10, true }, { 0, true },  { 5, true } } },
+            { "D Minor",   140.0f, { { 2, false }, { 7, false }, { 2, false }, { 9, true } } },
+            { "A# Major",  100.0f, { { 10, true }, { 3, true },  { 5, true },  { 10, true } } },
+            { "F# Minor",  132.0f, { { 6, false }, { 11, false }, { 6, false }, { 1, true } } },
+        };
+    }
+
+    // 30 s mono render at 44.1 kHz
+    static juce::AudioBuffer<float> render (const Item& item, double sampleRate)
+    {
+        const double seconds = 30.0;
+        const double beatSeconds = 60.0 / item.bpm;
+        const auto twoPi = juce::MathConstants<double>::twoPi;
+        const int numSamples = (int) (seconds * sampleRate);
+
+        juce::AudioBuffer<float> buffer (1, numSamples);
+        auto* out = buffer.getWritePointer (0);
+        juce::Random random (7);
+
+        auto hz = [] (int midi) { return 440.0 * std::pow (2.0, (midi - 69) / 12.0); };
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double t = (double) i / sampleRate;
+            const int beat = (int) (t / beatSeconds);
+            const double sinceBeat  = t - beat * beatSeconds;
+            const double sinceEighth = std::fmod (t, 0.5 * beatSeconds);
+            const auto& chord = item.progression[(size_t) (beat / 4) % item.progression.size()];
+
+            // Triad in the octave above middle C, four harmonics at 1/h
+            double pad = 0.0;
+            for (int interval : { 0, chord.isMajor ? 4 : 3, 7 })
+            {
+                const double f = hz (60 + (chord.root + interval) % 12);
+                for (int h = 1; h <= 4; ++h)
+                    pad += std::sin (twoPi * f * h * t) / h;
+            }
+
+            const double bassF = hz (36 + chord.root);
+            const double bass = std::sin (twoPi * bassF * t) + 0.5 * std::sin (twoPi * 2.0 * bassF * t);
+
+            // Kick on every beat, snare on 2 and 4, closed hat on the eighths
+            double drums = 0.0;
+            if (sinceBeat < 0.15)
+                drums += 0.8 * std::sin (twoPi * 55.0 * sinceBeat) * std::exp (-sinceBeat / 0.05);
+            if (beat % 2 == 1 && sinceBeat < 0.1)
+                drums += 0.4 * (random.nextFloat() - 0.5f) * std::exp (-sinceBeat / 0.03);
+            if (sinceEighth < 0.02)
+                drums += 0.1 * (random.nextFloat() - 0.5f) * std::exp (-sinceEighth / 0.004);
+
+            out[i] = (float) (0.04 * pad + 0.12 * bass + drums);
+        }
+        return buffer;
+    }
+
+    // Writes the item to a temporary WAV and analyses it on the analyzer's
+    // own thread, as the editor would
+    static bool analyse (AudioAnalyzer& analyzer, const Item& item)
+    {
+        const double sampleRate = 44100.0;
+        juce::TemporaryFile wav (".wav");
+        {
+            auto buffer = render (item, sampleRate);
+            std::unique_ptr<juce::AudioFormatWriter> writer (juce::WavAudioFormat().createWriterFor (
+                new juce::FileOutputStream (wav.getFile()), sampleRate, 1, 16, {}, 0));
+            if (writer == nullptr || ! writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples()))
+                return false;
+        }
+
+        analyzer.analyzeFile (wav.getFile(), sampleRate);
+        for (int waited = 0; waited < 60000; waited += 20)
+        {
+            if (analyzer.isAnalysisComplete())
+                return true;
+            juce::Thread::sleep (20);
+        }
+        return false;
+    }
+
+    void runTest() override
+    {
+        beginTest ("Key and BPM on the labelled corpus");
+
+        for (const auto& item : corpus())
+        {
+            AudioAnalyzer analyzer;
+            const juce::String label = juce::String (item.key) + " at " + juce::String (item.bpm, 0) + " BPM";
+            if (! analyse (analyzer, item))
+            {
+                expect (false, label + ": analysis did not finish");
+                continue;
+            }
+
+            expectEquals (analyzer.getDetectedKeyName(), juce::String (item.key), label);
+            expectWithinAbsoluteError (analyzer.getDetectedBPM(), item.bpm, 0.01f * item.bpm,
+                                       label + " read as " + juce::String (analyzer.getDetectedBPM(), 2));
+        }
+    }
+};
+
+static AnalysisRegressionTests analysisRegressionTests;
+
+#endif
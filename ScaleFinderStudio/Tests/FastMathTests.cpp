@@ -0,0 +1,65 @@
+#include <JuceHeader.h>
+#include "../Source/FastMath.h"
+
+#if JUCE_UNIT_TESTS
+
+// ── FastMath accuracy contract ───────────────────────────────────────────
+// Checks the error bounds and the exact / saturating results documented in
+// FastMath.h, in whichever mode SCALEFINDER_FAST_MATH selects.
+class FastMathTests : public juce::UnitTest
+{
+public:
+    FastMathTests() : juce::UnitTest ("FastMath", "ScaleFinder") {}
+
+    void runTest() override
+    {
+        beginTest ("Exact and saturating results");
+        {
+            expectEquals (fastmath::log1p (0.0f), 0.0f);
+            expectEquals (fastmath::log2 (1.0f), 0.0f);
+            for (int k = -126; k <= 127; ++k)
+                expectEquals (fastmath::log2 (std::ldexp (1.0f, k)), (float) k, "log2 of a power of two");
+
+            float low = fastmath::exp2 (-1000.0f);
+            expect (low > 0.0f && low <= std::ldexp (1.0f, -126), "exp2 underflow saturates above 0");
+            float high = fastmath::exp2 (1000.0f);
+            expect (std::isfinite (high) && high > 3.0e38f, "exp2 overflow saturates below inf");
+            expect (std::isfinite (fastmath::exp (1000.0f)), "exp overflow saturates below inf");
+        }
+
+        beginTest ("Error bounds over the documented ranges");
+        {
+            double maxLog2 = 0.0, maxLog = 0.0, maxLog1p = 0.0, maxRsqrt = 0.0;
+            for (double e = -125.0; e < 127.0; e += 0.001)
+            {
+                float x = (float) std::exp2 (e);
+                maxLog2  = juce::jmax (maxLog2,  std::abs ((double) fastmath::log2 (x) - std::log2 ((double) x)));
+                maxLog   = juce::jmax (maxLog,   std::abs ((double) fastmath::log (x) - std::log ((double) x)));
+                maxRsqrt = juce::jmax (maxRsqrt, std::abs ((double) fastmath::rsqrt (x) * std::sqrt ((double) x) - 1.0));
+            }
+            for (double e = -30.0; e < 29.8; e += 0.001)
+            {
+                float x = (float) std::exp2 (e);
+                maxLog1p = juce::jmax (maxLog1p, std::abs ((double) fastmath::log1p (x) - std::log1p ((double) x)));
+            }
+            expectLessOrEqual (maxLog2,  7.0e-6, "log2");
+            expectLessOrEqual (maxLog,   9.0e-6, "log");
+            expectLessOrEqual (maxLog1p, 4.0e-6, "log1p");
+            expectLessOrEqual (maxRsqrt, 5.0e-6, "rsqrt");
+
+            double maxExp2 = 0.0, maxExp = 0.0;
+            for (double x = -125.0; x < 127.0; x += 0.001)
+            {
+                float fx = (float) x, fy = (float) (x * 0.6931471805599453);
+                maxExp2 = juce::jmax (maxExp2, std::abs ((double) fastmath::exp2 (fx) / std::exp2 ((double) fx) - 1.0));
+                maxExp  = juce::jmax (maxExp,  std::abs ((double) fastmath::exp (fy) / std::exp ((double) fy) - 1.0));
+            }
+            expectLessOrEqual (maxExp2, 2.0e-7, "exp2");
+            expectLessOrEqual (maxExp,  4.0e-6, "exp");
+        }
+    }
+};
+
+static FastMathTests fastMathTests;
+
+#endif
@@ -0,0 +1,103 @@
+#include <JuceHeader.h>
+#include "../Source/LiveTempoTracker.h"
+#include "../Source/TempoDisplay.h"
+
+#if JUCE_UNIT_TESTS
+
+// ── Live tempo tracker ───────────────────────────────────────────────────
+// Feeds a kick-on-the-beat, hat-on-the-off-beat loop through the tracker's
+// real audio → worker path. Either octave of the beat may win (the hats
+// alone pulse at double time, the kicks at half time resonate too), but a
+// wrong octave must come with a low confidence, while an unambiguous
+// reading still scores well above it. A clean beat must then make it all
+// the way into the BPM pill.
+class LiveTempoTrackerTests : public juce::UnitTest
+{
+public:
+    LiveTempoTrackerTests() : juce::UnitTest ("Live tempo tracker", "ScaleFinder") {}
+
+    void runTest() override
+    {
+        beginTest ("Octave errors are not confident");
+
+        const double sampleRate = 44100.0;
+        float highestRight = 0.0f, highestWrong = 0.0f;
+        for (float tempo : { 72.0f, 96.0f, 128.0f, 174.0f })
+        {
+            LiveTempoTracker tracker;
+            tracker.prepare (sampleRate);
+            play (tracker, sampleRate, tempo, 12.0, true);
+            tracker.release();
+
+            const float bpm = tracker.getBPM(), confidence = tracker.getConfidence();
+            const auto near = [bpm] (float target) { return std::abs (bpm - target) < 0.02f * target; };
+
+            if (near (tempo))
+                highestRight = juce::jmax (highestRight, confidence);
+            else if (near (2.0f * tempo) || near (0.5f * tempo))
+                highestWrong = juce::jmax (highestWrong, confidence);
+            else
+                expect (false, "Tempo " + juce::String (tempo) + " read as " + juce::String (bpm));
+        }
+        expectLessThan (highestWrong, LiveTempoTracker::displayThreshold, "Octave errors must report low confidence");
+        expectGreaterThan (highestRight, LiveTempoTracker::displayThreshold, "Clear right-octave readings must stay confident");
+
+        beginTest ("A clean beat reaches the BPM pill");
+
+        for (float tempo : { 96.0f, 120.0f, 140.0f })
+        {
+            LiveTempoTracker tracker;
+            tracker.prepare (sampleRate);
+            play (tracker, sampleRate, tempo, 12.0, false);
+            tracker.release();
+
+            tempodisplay::Readings readings;
+            readings.liveBPM        = tracker.getBPM();
+            readings.liveConfidence = tracker.getConfidence();
+            readings.fileBPM        = 100.0f;
+            readings.fileConfidence = 0.9f;
+
+            auto choice = tempodisplay::choose (readings);
+            expect (choice.source == tempodisplay::Source::live,
+                    "Live " + juce::String (tempo) + " BPM not shown, confidence " + juce::String (readings.liveConfidence));
+            expectWithinAbsoluteError (choice.bpm, tempo, 0.02f * tempo);
+        }
+    }
+
+private:
+    // Decaying 60 Hz kick on each beat, plus either a noise hat half a beat
+    // later or a noise click on the kick itself. Blocks are paced (~40× real
+    // time) so the worker never lets the FIFO overflow.
+    static void play (LiveTempoTracker& tracker, double sampleRate, float tempo, double seconds, bool offBeatHats)
+    {
+        const double period = sampleRate * 60.0 / tempo;
+        juce::Random random (1);
+        std::vector<float> block (2048);
+        const float* channels[] = { block.data() };
+
+        for (int64_t start = 0; start < (int64_t) (seconds * sampleRate); start += (int64_t) block.size())
+        {
+            for (size_t i = 0; i < block.size(); ++i)
+            {
+                const double beatPhase = std::fmod ((double) (start + (int64_t) i), period) / sampleRate;
+                const double hatPhase  = std::fmod ((double) (start + (int64_t) i) + 0.5 * period, period) / sampleRate;
+                float sample = 0.001f * (random.nextFloat() - 0.5f);
+                if (beatPhase < 0.1)
+                    sample += (float) (0.6 * std::sin (2.0 * juce::MathConstants<double>::pi * 60.0 * beatPhase)
+                                       * std::exp (-beatPhase / 0.05));
+                if (offBeatHats && hatPhase < 0.01)
+                    sample += 0.08f * (random.nextFloat() - 0.5f) * (float) std::exp (-hatPhase / 0.003);
+                else if (! offBeatHats && beatPhase < 0.01)
+                    sample += 0.3f * (random.nextFloat() - 0.5f) * (float) std::exp (-beatPhase / 0.003);
+                block[i] = sample;
+            }
+            tracker.pushSamples (channels, 1, (int) block.size());
+            juce::Thread::sleep (1);
+        }
+        juce::Thread::sleep (200);
+    }
+};
+
+static LiveTempoTrackerTests liveTempoTrackerTests;
+
+#endif
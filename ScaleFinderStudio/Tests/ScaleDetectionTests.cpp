@@ -0,0 +1,109 @@
+#include <JuceHeader.h>
+#include "../Source/KeyProfiles.h"
+
+#if JUCE_UNIT_TESTS
+
+// ── Mode / extended scale detection ──────────────────────────────────────
+// The chroma here is built from chord progressions and a melody, frame by
+// frame the way the analyzer accumulates it, never from the scale masks
+// themselves, so a pass means the masks separate real pitch content. The
+// tonic is never handed over: like the analyzer, the test starts from the
+// summed chroma and bass chroma alone. Each vamp rests on its tonic chord
+// a little longer than on the other chord; an evenly split two-chord vamp
+// (Dm7–G) is D Dorian and G Mixolydian alike once it is summed.
+class ScaleDetectionTests : public juce::UnitTest
+{
+public:
+    ScaleDetectionTests() : juce::UnitTest ("Scale detection", "ScaleFinder") {}
+
+    void runTest() override
+    {
+        const std::vector<int> maj { 0, 4, 7 }, min { 0, 3, 7 }, min7 { 0, 3, 7, 10 }, power { 0, 7 };
+
+        struct Case { const char* name; int tonic; int scale; Song song; };
+        const Case cases[] = {
+            { "C Major",            0, 0, song ({ { 0, maj, 4 }, { 5, maj, 2 }, { 7, maj, 2 } }, 0, 0) },
+            { "A Minor",            9, 1, song ({ { 9, min, 4 }, { 2, min, 2 }, { 4, min, 2 }, { 5, maj, 2 } }, 9, 1) },
+            { "D Dorian",           2, 2, song ({ { 2, min7, 4 }, { 7, maj, 3 } }, 2, 2) },
+            { "E Phrygian",         4, 3, song ({ { 4, min, 4 }, { 5, maj, 3 } }, 4, 3) },
+            { "F Lydian",           5, 4, song ({ { 5, maj, 4 }, { 7, maj, 3 } }, 5, 4) },
+            { "G Mixolydian",       7, 5, song ({ { 7, maj, 4 }, { 5, maj, 2 }, { 0, maj, 2 } }, 7, 5) },
+            { "A Harmonic Minor",   9, 6, song ({ { 9, min, 4 }, { 2, min, 2 }, { 4, maj, 2 } }, 9, 6) },
+            { "A Melodic Minor",    9, 7, song ({ { 9, min, 4 }, { 2, maj, 2 }, { 4, maj, 2 } }, 9, 7) },
+            { "C Major Pentatonic", 0, 8, song ({ { 0, power, 4 }, { 9, power, 3 } }, 0, 8) },
+            { "A Minor Pentatonic", 9, 9, song ({ { 9, power, 4 }, { 2, power, 3 } }, 9, 9) },
+        };
+
+        beginTest ("Mode and tonic from chroma and bass");
+        for (const auto& c : cases)
+            expectMatch (c.song.chroma, c.song.bass, c, c.name);
+
+        beginTest ("Mode and tonic from chroma alone");
+        const Chroma noBass {};
+        for (const auto& c : cases)
+            expectMatch (c.song.chroma, noBass, c, c.name);
+    }
+
+private:
+    using Chroma = std::array<double, 12>;
+    struct Chord { int root; std::vector<int> tones; int frames; };
+    struct Song { Chroma chroma, bass; };
+
+    // The analyzer's path from summed chroma to a scale: mask correlation
+    // once, bass tonic bonus, then keyprofiles::bestScale
+    template <typename Case>
+    void expectMatch (const Chroma& chroma, const Chroma& bass, const Case& c, const char* name)
+    {
+        double scaleCorr[keyprofiles::numScaleCandidates];
+        keyprofiles::correlate (keyprofiles::SCALE_TEMPLATES, chroma.data(), 1, scaleCorr);
+        double tonicBonus[12];
+        keyprofiles::bassTonicBonus (bass.data(), 0.05, tonicBonus);
+
+        const auto match = keyprofiles::bestScale (scaleCorr, chroma.data(), tonicBonus);
+        expectEquals (match.root, c.tonic, name);
+        expectEquals (juce::String (MusicTheory::SCALES[match.scale].name),
+                      juce::String (MusicTheory::SCALES[c.scale].name), name);
+    }
+
+    // Each frame holds the current chord (root 1, other tones 0.7) plus one
+    // melody note stepping up the scale; every note leaks 15% into the fifth
+    // above, as its third harmonic does. Frames are log-compressed and
+    // L2-normalised before they are summed, like the analyzer's chroma. The
+    // bass plays the chord root.
+    static Song song (std::initializer_list<Chord> chords, int tonic, int melodyScale)
+    {
+        const auto& melody = MusicTheory::SCALES[melodyScale];
+        Song sum {};
+        int step = 0;
+        for (int pass = 0; pass < 4; ++pass)
+            for (const auto& chord : chords)
+                for (int f = 0; f < chord.frames; ++f)
+                {
+                    Chroma notes {}, x {};
+                    for (size_t i = 0; i < chord.tones.size(); ++i)
+                        notes[(size_t) ((chord.root + chord.tones[i]) % 12)] += i == 0 ? 1.0 : 0.7;
+                    notes[(size_t) ((tonic + melody.intervals[step++ % melody.numNotes]) % 12)] += 1.0;
+
+                    for (int pc = 0; pc < 12; ++pc)
+                    {
+                        x[(size_t) pc] += notes[(size_t) pc];
+                        x[(size_t) ((pc + 7) % 12)] += 0.15 * notes[(size_t) pc];
+                    }
+
+                    double norm = 0.0;
+                    for (auto& v : x)
+                    {
+                        v = std::log1p (10.0 * v);
+                        norm += v * v;
+                    }
+                    for (int pc = 0; pc < 12; ++pc)
+                        sum.chroma[(size_t) pc] += x[(size_t) pc] / std::sqrt (norm);
+                    sum.bass[(size_t) chord.root] += 1.0;
+                }
+        return sum;
+    }
+};
+
+static ScaleDetectionTests scaleDetectionTests;
+
+#endif
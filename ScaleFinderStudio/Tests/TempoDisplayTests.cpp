@@ -0,0 +1,52 @@
+#include <JuceHeader.h>
+#include "../Source/TempoDisplay.h"
+
+#if JUCE_UNIT_TESTS
+
+// ── BPM pill source selection ────────────────────────────────────────────
+// Every DAW reports a tempo, playing or not, so the host may only hide the
+// file's own tempo while its transport runs or when the user follows it.
+class TempoDisplayTests : public juce::UnitTest
+{
+public:
+    TempoDisplayTests() : juce::UnitTest ("Tempo display", "ScaleFinder") {}
+
+    void runTest() override
+    {
+        using tempodisplay::Source;
+
+        tempodisplay::Readings r;
+        r.hostBPM = 120.0f;
+        r.fileBPM = 97.0f;
+        r.fileConfidence = 0.8f;
+
+        beginTest ("A stopped host does not replace the file tempo");
+        expect (tempodisplay::choose (r).source == Source::file);
+        expectEquals (tempodisplay::choose (r).bpm, 97.0f);
+
+        beginTest ("A playing or followed host wins");
+        r.hostPlaying = true;
+        expect (tempodisplay::choose (r).source == Source::host);
+        r.hostPlaying = false;
+        r.followHost = true;
+        expect (tempodisplay::choose (r).source == Source::host);
+        r.followHost = false;
+
+        beginTest ("Live input outranks a stopped host");
+        r.fileBPM = 0.0f;
+        r.liveBPM = 126.0f;
+        r.liveConfidence = LiveTempoTracker::displayThreshold;
+        expect (tempodisplay::choose (r).source == Source::live);
+        r.liveConfidence = 0.5f * LiveTempoTracker::displayThreshold;
+        expect (tempodisplay::choose (r).source == Source::host, "Stopped host is the fallback");
+
+        beginTest ("Manual entry wins over everything");
+        r.manualBPM = 90.0f;
+        r.hostPlaying = true;
+        expectEquals (tempodisplay::choose (r).bpm, 90.0f);
+    }
+};
+
+static TempoDisplayTests tempoDisplayTests;
+
+#endif
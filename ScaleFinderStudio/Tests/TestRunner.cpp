@@ -0,0 +1,44 @@
+#include <JuceHeader.h>
+
+#if JUCE_UNIT_TESTS
+
+// ── Test runner ──────────────────────────────────────────────────────────
+// Console entry point for the tests in this folder. Build a console app
+// with JUCE_UNIT_TESTS=1 from Tests/*.cpp and Source/*.cpp minus
+// PluginProcessor.cpp and PluginEditor.cpp (plus juce_audio_formats for the
+// analysis corpus), then run it with no arguments for every ScaleFinder
+// test or with test names to run just those. Exits non-zero when any check
+// fails, so it can gate a build.
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::Array<juce::UnitTest*> tests;
+    for (auto* test : juce::UnitTest::getTestsInCategory ("ScaleFinder"))
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            selected = selected || test->getName() == juce::String (argv[i]);
+
+        if (selected)
+            tests.add (test);
+    }
+
+    if (tests.isEmpty())
+    {
+        juce::Logger::writeToLog ("No matching tests");
+        return 1;
+    }
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure (false);
+    runner.runTests (tests);
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult (i)->failures;
+
+    return failures > 0 ? 1 : 0;
+}
+
+#endif